@@ -11,6 +11,22 @@
 #include <quantum/qubist.hpp>
 #include <cyberpunk/core.hpp>
 #include <temporal/blockchain.hpp>
+#include <immintrin.h>
+#include <cpuid.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 namespace SatoshiMirror {
 
@@ -23,11 +39,653 @@ qtype QubistDict = std::unordered_map<QubistString, qvariant>;
 qtype QubistList = std::vector<qvariant>;
 qtype QubistTime = std::chrono::system_clock::time_point;
 
+// ==================== HASH256 ====================
+// Digests stay 32 raw bytes everywhere; hex exists only at the JSON and
+// console boundary. The codec does 16 bytes per SSSE3 shuffle.
+namespace Hex {
+
+__attribute__((target("ssse3")))
+static qfunc encode_ssse3(const uint8_t* in, size_t length, char* out) -> size_t {
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    size_t done = 0;
+    for(; done + 16 <= length; done += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), low_nibble));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, low_nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return done;
+}
+
+// 16 hex characters to 8 bytes per step; stops at the first invalid block
+__attribute__((target("ssse3")))
+static qfunc decode_ssse3(const char* in, size_t length, uint8_t* out) -> size_t {
+    const __m128i nine = _mm_set1_epi8(9), five = _mm_set1_epi8(5);
+    const __m128i weights = _mm_set1_epi16(0x0110);       // high nibble * 16 + low nibble
+    size_t done = 0;
+    for(; done + 8 <= length; done += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * done));
+        __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+        __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+        __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, five), alpha);
+        if(_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff) break;
+        __m128i nibbles = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                                       _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+        __m128i pairs = _mm_maddubs_epi16(nibbles, weights);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + done), _mm_packus_epi16(pairs, pairs));
+    }
+    return done;
+}
+
+static inline qfunc nibble(char c) -> int {
+    if(c >= '0' && c <= '9') return c - '0';
+    c = char(c | 0x20);
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static qfunc has_ssse3() -> QubistBool {
+    static const bool hardware = __builtin_cpu_supports("ssse3");
+    return hardware;
+}
+
+// Writes 2 * length lowercase characters
+static qfunc encode(const uint8_t* in, size_t length, char* out) -> void {
+    size_t i = has_ssse3() ? encode_ssse3(in, length, out) : 0;
+    for(; i < length; i++) {
+        out[2 * i] = "0123456789abcdef"[in[i] >> 4];
+        out[2 * i + 1] = "0123456789abcdef"[in[i] & 15];
+    }
+}
+
+// Reads 2 * length characters of either case; false on any non-hex digit
+static qfunc decode(const char* in, size_t length, uint8_t* out) -> QubistBool {
+    size_t i = has_ssse3() ? decode_ssse3(in, length, out) : 0;
+    for(; i < length; i++) {
+        int hi = nibble(in[2 * i]), lo = nibble(in[2 * i + 1]);
+        if(hi < 0 || lo < 0) return false;
+        out[i] = uint8_t(hi << 4 | lo);
+    }
+    return true;
+}
+
+} // namespace Hex
+
+struct Hash256 {
+    std::array<uint8_t, 32> raw{};
+
+    static constexpr size_t hex_size = 64;
+
+    constexpr qfunc data() -> uint8_t* { return raw.data(); }
+    constexpr qfunc data() const -> const uint8_t* { return raw.data(); }
+    constexpr qfunc operator[](size_t i) -> uint8_t& { return raw[i]; }
+    constexpr qfunc operator[](size_t i) const -> uint8_t { return raw[i]; }
+    constexpr qfunc operator==(const Hash256&) const -> bool = default;
+    constexpr qfunc operator<=>(const Hash256&) const = default;
+
+    // First 8 bytes as a word; digests are uniform, so this is already a good hash
+    qfunc head_word() const -> uint64_t {
+        uint64_t word;
+        std::memcpy(&word, raw.data(), sizeof(word));
+        return word;
+    }
+
+    static qfunc of(const void* data, size_t length) -> Hash256 {
+        Hash256 digest;
+        SHA256(static_cast<const unsigned char*>(data), length, digest.data());
+        return digest;
+    }
+
+    static qfunc from_hex(std::string_view hex) -> Hash256 {
+        Hash256 digest;
+        if(hex.size() != hex_size || !Hex::decode(hex.data(), 32, digest.data())) {
+            throw std::invalid_argument("malformed hash: " + std::string(hex));
+        }
+        return digest;
+    }
+
+    qfunc write_hex(char* out) const -> void { Hex::encode(raw.data(), 32, out); }
+
+    qfunc to_hex() const -> QubistString {
+        QubistString hex(hex_size, '\0');
+        write_hex(hex.data());
+        return hex;
+    }
+
+    struct Hasher {
+        qfunc operator()(const Hash256& digest) const -> size_t { return size_t(digest.head_word()); }
+    };
+};
+static_assert(sizeof(Hash256) == 32 && alignof(Hash256) == 1, "Hash256 must pack into headers");
+
+// ==================== DETERMINISTIC SIMULATION ====================
+// Every clock read and random draw goes through here. Normal runs get the
+// system clocks and std::random_device; `--deterministic --seed N` swaps in
+// a virtual clock and seed-derived streams, so repeated runs give identical
+// chains, output and telemetry.
+//
+// Virtual time is per thread and starts at the same epoch everywhere. Only
+// the thread doing the work moves it (a solved block by its simulated
+// search time, a sensor by its interval), so helper threads always measure
+// the same zero-length spans no matter how they are scheduled.
+namespace Simulation {
+
+constexpr int64_t epoch_ms = 1231006505000;     // 2009-01-03 18:15:05 UTC
+constexpr QubistFloat hash_rate = 1e6;           // virtual hashes per second
+
+inline QubistBool deterministic = false;
+inline uint64_t seed = 0;
+inline thread_local std::chrono::nanoseconds elapsed{0};
+
+static qfunc enable(uint64_t run_seed) -> void {
+    deterministic = true;
+    seed = run_seed;
+}
+
+static qfunc enabled() -> QubistBool { return deterministic; }
+
+// Monotonic clock for measuring spans
+static qfunc now() -> std::chrono::steady_clock::time_point {
+    if(!deterministic) return std::chrono::steady_clock::now();
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(elapsed));
+}
+
+// Wall clock, unix milliseconds
+static qfunc unix_ms() -> int64_t {
+    if(deterministic) return epoch_ms + std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static qfunc unix_time() -> std::time_t { return std::time_t(unix_ms() / 1000); }
+
+static qfunc advance(std::chrono::nanoseconds span) -> void {
+    if(deterministic) elapsed += span;
+}
+
+// Simulated work: `hashes` at hash_rate
+static qfunc advance_hashes(QubistInt hashes) -> void {
+    advance(std::chrono::nanoseconds(QubistInt(QubistFloat(hashes) / hash_rate * 1e9)));
+}
+
+// Still paces the console in real time; virtual time moves by exactly `span`
+static qfunc sleep(std::chrono::nanoseconds span) -> void {
+    advance(span);
+    std::this_thread::sleep_for(span);
+}
+
+// SHA-256(seed | stream | index): the index-th value of a named stream
+static qfunc derive(std::string_view stream, uint64_t index) -> Hash256 {
+    std::string material(16, '\0');
+    std::memcpy(material.data(), &seed, 8);
+    std::memcpy(material.data() + 8, &index, 8);
+    material.append(stream);
+    return Hash256::of(material.data(), material.size());
+}
+
+// One engine per named stream, so components on different threads never
+// interleave their draws
+static qfunc engine(std::string_view stream) -> std::mt19937_64 {
+    if(deterministic) return std::mt19937_64(derive(stream, 0).head_word());
+    std::random_device device;
+    return std::mt19937_64((uint64_t(device()) << 32) | device());
+}
+
+} // namespace Simulation
+
+// ==================== TRANSACTIONS & MEMPOOL ====================
+// Grants mint mirror BTC to an agent; transfers move it between agents. Both
+// wait in the mempool until a block carries them, and balances only change
+// once that block is appended.
+struct QuantumTransaction {
+    enum Kind : uint8_t { grant = 1, transfer = 2 };
+
+    Kind kind = grant;
+    QubistString from;                // empty for grants
+    QubistString to;
+    QubistFloat amount = 0.0;
+    QubistFloat fee = 0.0;
+    uint64_t timestamp = 0;           // unix ms; keeps repeated payments distinct
+    Hash256 id;                       // SHA-256 of encode()
+    uint32_t bytes = 0;               // encoded size
+
+    // kind | timestamp | amount | fee | len from | len to, little-endian
+    qfunc encode() const -> std::string {
+        std::string out;
+        out.reserve(27 + from.size() + to.size());
+        out.push_back(char(kind));
+        out.append(reinterpret_cast<const char*>(&timestamp), 8);
+        out.append(reinterpret_cast<const char*>(&amount), 8);
+        out.append(reinterpret_cast<const char*>(&fee), 8);
+        out.push_back(char(from.size()));
+        out.append(from);
+        out.push_back(char(to.size()));
+        out.append(to);
+        return out;
+    }
+
+    // Consumes one encoded transaction from the front of `in`
+    static qfunc decode(std::string_view& in, QuantumTransaction& tx) -> QubistBool {
+        if(in.size() < 27) return false;
+        tx.kind = Kind(uint8_t(in[0]));
+        std::memcpy(&tx.timestamp, in.data() + 1, 8);
+        std::memcpy(&tx.amount, in.data() + 9, 8);
+        std::memcpy(&tx.fee, in.data() + 17, 8);
+        size_t from_len = uint8_t(in[25]);
+        if(in.size() < 27 + from_len) return false;
+        tx.from.assign(in.data() + 26, from_len);
+        size_t to_len = uint8_t(in[26 + from_len]);
+        if(in.size() < 27 + from_len + to_len) return false;
+        tx.to.assign(in.data() + 27 + from_len, to_len);
+        in.remove_prefix(27 + from_len + to_len);
+        tx.seal();
+        return true;
+    }
+
+    // Checks the fields and fixes id and size
+    qfunc seal() -> void {
+        if(kind != grant && kind != transfer) throw std::invalid_argument("unknown transaction kind");
+        if(to.empty() || to.size() > 255 || from.size() > 255) throw std::invalid_argument("bad agent id");
+        if(kind == transfer && (from.empty() || from == to)) throw std::invalid_argument("transfer needs two agents");
+        if(!(amount > 0.0) || !(fee >= 0.0)) throw std::invalid_argument("amount must be positive and fee non-negative");
+        std::string encoded = encode();
+        id = Hash256::of(encoded.data(), encoded.size());
+        bytes = uint32_t(encoded.size());
+    }
+
+    qfunc fee_rate() const -> QubistFloat { return fee / bytes; }
+
+    // What the sender gives up: amount plus fee for transfers, nothing for grants
+    qfunc spend() const -> QubistFloat { return kind == transfer ? amount + fee : 0.0; }
+};
+
+using TxId = Hash256;
+
+// Bitcoin-style merkle tree over the coinbase digest and transaction ids
+// (odd levels repeat their last node); with no transactions the root is the
+// coinbase digest itself.
+static qfunc merkle_root(const Hash256& coinbase, const std::vector<QuantumTransaction>& transactions) -> Hash256 {
+    std::vector<Hash256> level(1 + transactions.size());
+    level[0] = coinbase;
+    for(size_t i = 0; i < transactions.size(); i++) level[i + 1] = transactions[i].id;
+
+    while(level.size() > 1) {
+        if(level.size() & 1) level.push_back(level.back());
+        for(size_t i = 0; i < level.size() / 2; i++) {
+            Hash256 pair[2] = {level[2 * i], level[2 * i + 1]};
+            level[i] = Hash256::of(pair, sizeof(pair));
+        }
+        level.resize(level.size() / 2);
+    }
+    return level[0];
+}
+
+// Pending transactions indexed by id and by agent, with a max-heap on fee
+// rate for block assembly. Assembly pops the best transactions that fit, so
+// a block of k transactions costs O(k log n) whatever the backlog; they are
+// removed as they are taken and never offered to a second template. A taken
+// transfer keeps its sender's spend reserved until its block is connected
+// (remove) or its template is thrown away (restore).
+class Mempool {
+private:
+    struct Ranked {
+        QubistFloat fee_rate;
+        uint64_t sequence;            // arrival order breaks ties, oldest first
+        QuantumTransaction* tx;       // map nodes never move
+
+        qfunc operator<(const Ranked& other) const -> bool {
+            if(fee_rate != other.fee_rate) return fee_rate < other.fee_rate;
+            return sequence > other.sequence;
+        }
+    };
+
+    static constexpr size_t min_transaction_bytes = 28;
+    static constexpr size_t max_skips = 64;     // oversized transactions passed over per block
+
+    mutable std::mutex mutex;
+    size_t capacity;
+    std::unordered_map<TxId, QuantumTransaction, Hash256::Hasher> by_id;
+    std::unordered_map<QubistString, std::unordered_set<TxId, Hash256::Hasher>> by_agent;
+    std::unordered_map<QubistString, QubistFloat> pending_spend;
+    std::priority_queue<Ranked> by_fee_rate;
+    std::unordered_set<TxId, Hash256::Hasher> evicted;    // confirmed elsewhere; dropped when popped
+    std::unordered_map<TxId, QuantumTransaction, Hash256::Hasher> taken;    // in a template, not yet connected
+    uint64_t sequence = 0;
+    size_t pending_bytes = 0;
+
+    qfunc unindex_agent(const QubistString& agent, const TxId& id) -> void {
+        auto it = by_agent.find(agent);
+        it->second.erase(id);
+        if(it->second.empty()) by_agent.erase(it);
+    }
+
+    // Adds a transaction to the heap and every index but pending_spend
+    qfunc index(QuantumTransaction tx) -> void {
+        TxId id = tx.id;
+        if(tx.kind == QuantumTransaction::transfer) by_agent[tx.from].insert(id);
+        by_agent[tx.to].insert(id);
+        pending_bytes += tx.bytes;
+        QuantumTransaction& stored = by_id.emplace(id, std::move(tx)).first->second;
+        by_fee_rate.push(Ranked{stored.fee_rate(), sequence++, &stored});
+    }
+
+    // Drops a transaction from the agent index and the byte count
+    qfunc unindex(const QuantumTransaction& tx) -> void {
+        pending_bytes -= tx.bytes;
+        if(tx.kind == QuantumTransaction::transfer) unindex_agent(tx.from, tx.id);
+        unindex_agent(tx.to, tx.id);
+    }
+
+    qfunc release_spend(const QuantumTransaction& tx) -> void {
+        if(tx.kind != QuantumTransaction::transfer) return;
+        auto spend = pending_spend.find(tx.from);
+        spend->second -= tx.spend();
+        if(spend->second <= 0.0) pending_spend.erase(spend);
+    }
+
+public:
+    qfunc Mempool(size_t max_transactions = 250000) : capacity(max_transactions) {}
+
+    // `sender_balance` is the ledger balance of tx.from (ignored for grants);
+    // throws std::invalid_argument with the reason a transaction is refused.
+    // A transaction evicted as confirmed (and since disconnected by a reorg)
+    // is taken back: its heap entry is still there, so only the indexes and
+    // its reservation are restored.
+    qfunc submit(QuantumTransaction tx, QubistFloat sender_balance) -> TxId {
+        tx.seal();
+        std::lock_guard<std::mutex> lock(mutex);
+        QubistBool revived = evicted.count(tx.id) > 0;
+        if(!revived && by_id.size() - evicted.size() >= capacity) throw std::invalid_argument("mempool full");
+        if(!revived && (by_id.count(tx.id) || taken.count(tx.id))) throw std::invalid_argument("duplicate transaction");
+        if(tx.kind == QuantumTransaction::grant && tx.fee != 0.0) throw std::invalid_argument("grants carry no fee");
+        if(tx.kind == QuantumTransaction::transfer) {
+            auto reserved = pending_spend.find(tx.from);      // a refused sender gets no entry
+            if((reserved == pending_spend.end() ? 0.0 : reserved->second) + tx.spend() > sender_balance) {
+                throw std::invalid_argument("insufficient balance for " + tx.from);
+            }
+        }
+
+        TxId id = tx.id;
+        if(tx.kind == QuantumTransaction::transfer) pending_spend[tx.from] += tx.spend();
+        if(revived) {
+            evicted.erase(id);
+            const QuantumTransaction& stored = by_id.at(id);
+            if(stored.kind == QuantumTransaction::transfer) by_agent[stored.from].insert(id);
+            by_agent[stored.to].insert(id);
+            pending_bytes += stored.bytes;
+        } else {
+            index(std::move(tx));
+        }
+        return id;
+    }
+
+    // Removes and returns the highest fee-rate transactions fitting `max_bytes`;
+    // transfer spends stay reserved until remove() or restore()
+    qfunc take_block(size_t max_bytes) -> std::vector<QuantumTransaction> {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<QuantumTransaction> block;
+        std::vector<Ranked> skipped;
+        size_t used = 0;
+
+        while(!by_fee_rate.empty() && max_bytes - used >= min_transaction_bytes && skipped.size() < max_skips) {
+            Ranked best = by_fee_rate.top();
+            by_fee_rate.pop();
+            if(evicted.erase(best.tx->id)) {
+                by_id.erase(best.tx->id);
+                continue;
+            }
+            if(used + best.tx->bytes > max_bytes) {
+                skipped.push_back(best);
+                continue;
+            }
+
+            QuantumTransaction& tx = *best.tx;
+            TxId id = tx.id;
+            used += tx.bytes;
+            unindex(tx);
+            taken.emplace(id, tx);
+            block.push_back(std::move(tx));
+            by_id.erase(id);
+        }
+        for(const Ranked& r : skipped) by_fee_rate.push(r);
+        return block;
+    }
+
+    // Forgets transactions a connected block confirmed: taken ones release
+    // their reservation (the ledger has booked them now); pending ones are
+    // only marked, since the heap keeps pointers into by_id, and freed when
+    // they reach the top.
+    qfunc remove(const std::vector<QuantumTransaction>& confirmed) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& tx : confirmed) {
+            if(auto held = taken.find(tx.id); held != taken.end()) {
+                release_spend(held->second);
+                taken.erase(held);
+                continue;
+            }
+            auto it = by_id.find(tx.id);
+            if(it == by_id.end() || evicted.count(tx.id)) continue;
+            unindex(it->second);
+            release_spend(it->second);
+            evicted.insert(tx.id);
+        }
+    }
+
+    // Puts a discarded template's transactions back; ones confirmed in the
+    // meantime are skipped. Their reservations were never released.
+    qfunc restore(const std::vector<QuantumTransaction>& transactions) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& tx : transactions) {
+            auto held = taken.find(tx.id);
+            if(held == taken.end()) continue;
+            index(std::move(held->second));
+            taken.erase(held);
+        }
+    }
+
+    qfunc for_agent(const QubistString& agent) const -> std::vector<QuantumTransaction> {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<QuantumTransaction> found;
+        auto it = by_agent.find(agent);
+        if(it == by_agent.end()) return found;
+        for(const TxId& id : it->second) found.push_back(by_id.at(id));
+        return found;
+    }
+
+    qfunc size() const -> size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        return by_id.size() - evicted.size();
+    }
+
+    qfunc bytes() const -> size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending_bytes;
+    }
+};
+
 // ==================== UNIFIED LEDGER SYSTEM ====================
+// Write-ahead log behind the ledger: one compact JSON line per mutation.
+// append() only buffers and returns a ticket; sync(ticket) waits until that
+// record is on disk. A flusher thread group-commits whatever has piled up,
+// with one write and one fdatasync per group, so records appended while a
+// sync is in flight share the next one. A failed write or sync stops the
+// log: every later append() and sync() throws. The log is flock()ed while
+// open, so only one process at a time writes a ledger.
+class LedgerJournal {
+private:
+    QubistString path;
+    int fd = -1;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable committed;
+    std::string pending;
+    uint64_t appended = 0;      // records handed to append()
+    uint64_t durable = 0;       // records written and synced
+    bool stopping = false;
+    QubistString failure;       // set once a write or sync fails
+    std::thread flusher;
+
+    qfunc open_log() -> void {
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0) throw std::runtime_error("cannot open ledger journal " + path + ": " + std::strerror(errno));
+        if(::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(fd);
+            throw std::runtime_error("ledger journal " + path + " is held by another process");
+        }
+    }
+
+    // Writes and syncs `data`; empty on success, else what failed
+    static qfunc write_all(int target, const std::string& data) -> QubistString {
+        size_t offset = 0;
+        while(offset < data.size()) {
+            ssize_t n = ::write(target, data.data() + offset, data.size() - offset);
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                return QubistString("write: ") + std::strerror(errno);
+            }
+            offset += size_t(n);
+        }
+        if(::fdatasync(target) != 0) return QubistString("fdatasync: ") + std::strerror(errno);
+        return "";
+    }
+
+    qfunc check() const -> void {
+        if(!failure.empty()) throw std::runtime_error("ledger journal " + path + " failed: " + failure);
+    }
+
+    qfunc run() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+            wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if(pending.empty()) break;
+            std::string batch;
+            batch.swap(pending);
+            uint64_t upto = appended;
+            lock.unlock();
+            QubistString error = write_all(fd, batch);
+            lock.lock();
+            if(!error.empty()) {
+                failure = error;
+                std::cout << "❌ Ledger journal " << path << " failed: " << failure << std::endl;
+                committed.notify_all();
+                break;
+            }
+            durable = upto;
+            committed.notify_all();
+        }
+    }
+
+public:
+    qfunc LedgerJournal(QubistString log_path) : path(std::move(log_path)) {
+        open_log();
+        flusher = std::thread([this]() { run(); });
+    }
+
+    // Commits everything still buffered
+    qfunc ~LedgerJournal() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        flusher.join();
+        ::close(fd);
+    }
+
+    qfunc append(const QubistString& record) -> uint64_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        check();
+        bool idle = pending.empty();
+        pending += record;
+        pending += '\n';
+        if(idle) wake.notify_one();      // later records ride along with this group
+        return ++appended;
+    }
+
+    // Blocks until record `ticket` (default: every appended one) is on disk
+    qfunc sync(uint64_t ticket = UINT64_MAX) -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t upto = std::min(ticket, appended);
+        committed.wait(lock, [this, upto]() { return durable >= upto || !failure.empty(); });
+        check();
+    }
+
+    // Moves everything logged so far to `retired` and carries on in a fresh
+    // log. A retired log that is still there (its checkpoint never landed)
+    // is extended, and synced before the live log goes; a crash in between
+    // leaves the records in both, and replay skips the repeats by seq. The
+    // old log stays open, and locked, until the new one is.
+    qfunc rotate(const QubistString& retired) -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        committed.wait(lock, [this]() { return durable == appended || !failure.empty(); });
+        check();
+        int old_fd = fd;
+        if(std::filesystem::exists(retired)) {
+            std::ifstream current(path, std::ios::binary);
+            std::string records((std::istreambuf_iterator<char>(current)), std::istreambuf_iterator<char>());
+            int older = ::open(retired.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+            if(older < 0) throw std::runtime_error("cannot extend ledger journal " + retired + ": " + std::strerror(errno));
+            QubistString error = write_all(older, records);
+            ::close(older);
+            if(!error.empty()) throw std::runtime_error("cannot extend ledger journal " + retired + ": " + error);
+            std::filesystem::remove(path);
+        } else {
+            std::filesystem::rename(path, retired);
+        }
+        open_log();
+        ::close(old_fd);
+    }
+
+    // Records of a log in order; a torn last line (crash mid-append) ends it
+    template <typename Fn>
+    static qfunc replay(const QubistString& log_path, Fn fn) -> QubistInt {
+        std::ifstream in(log_path);
+        std::string line;
+        QubistInt records = 0;
+        while(std::getline(in, line)) {
+            if(line.empty()) continue;
+            QubistDict record;
+            try {
+                record = json::parse(line);
+            } catch(const std::exception&) {
+                break;
+            }
+            fn(record);
+            records++;
+        }
+        return records;
+    }
+};
+
 class QuantumLedger {
 private:
     QubistDict ledger_data;
     QubistString ledger_file = "agents_ledger.json";
+    // agent id -> position in ledger_data["agents"]; rebuilt on load and kept
+    // in step with every append, so lookups never scan the array. Not saved
+    // with the checkpoint: loading already parses every agent, and one pass
+    // over them rebuilds it for less than reading a saved copy would cost.
+    std::unordered_map<QubistString, size_t> slots;
+    // Mutations go to the journal; the JSON file is a checkpoint holding
+    // every record up to checkpoint_seq, rewritten in the background. No
+    // journal means the ledger was only loaded for reading (open_journal()
+    // not called).
+    std::unique_ptr<LedgerJournal> journal;
+    uint64_t seq = 0;
+    uint64_t checkpoint_seq = 0;
+    QubistBool fresh = false;                  // no checkpoint on disk when loaded
+    std::vector<int64_t> loaded_from;          // disk_state() as load() found it
+    // Connected blocks' deltas, newest last, at most max_undo; saved under
+    // "undo" in the checkpoint but kept out of ledger_data, so a block
+    // appends in place instead of copying the list
+    std::deque<std::pair<QubistString, QubistList>> undo;
+    std::chrono::steady_clock::time_point last_checkpoint = Simulation::now();
+    std::future<void> compaction;
 
     qfunc build_domain_catalog() -> QubistList {
         return QubistList{
@@ -115,22 +773,258 @@ private:
         return json::parse(f);
     }
    
-    qfunc save_json(qpath path, QubistDict data) -> void {
-        std::ofstream f(path);
-        f << json::dump(data, 2);
+    qfunc journal_path() const -> QubistString { return ledger_file + ".wal"; }
+    qfunc retired_path() const -> QubistString { return ledger_file + ".wal.old"; }
+
+    // Checkpoint mtime and both logs' sizes (logs only grow, and an absent
+    // one counts as empty): whatever another writer did changes one of them
+    qfunc disk_state() const -> std::vector<int64_t> {
+        std::error_code error;
+        auto stamp = std::filesystem::last_write_time(ledger_file, error);
+        std::vector<int64_t> state = {error ? -1 : int64_t(stamp.time_since_epoch().count())};
+        for (const QubistString& path : {retired_path(), journal_path()}) {
+            auto size = std::filesystem::file_size(path, error);
+            state.push_back(error ? 0 : int64_t(size));
+        }
+        return state;
     }
 
-public:
-    qfunc QuantumLedger() {
+    // Checkpoint plus the records the logs hold past it: the retired log
+    // (if its checkpoint never landed), then the live one. Only reads, so
+    // a ledger another process is writing loads too.
+    qfunc load() -> void {
+        loaded_from = disk_state();
         ledger_data = load_json(ledger_file);
-        if (ledger_data.empty()) {
+        fresh = ledger_data.empty();
+        if (fresh) {
             ledger_data = {
                 {"domain_catalog", build_domain_catalog()},
                 {"agent_generator", build_agent_generator()},
                 {"agents", build_example_agents()}
             };
-            save_json(ledger_file, ledger_data);
         }
+        checkpoint_seq = ledger_data.count("checkpoint_seq") ? uint64_t(QubistInt(ledger_data["checkpoint_seq"])) : 0;
+        ledger_data.erase("checkpoint_seq");
+        undo.clear();
+        if (ledger_data.count("undo")) {
+            for (auto& entry : ledger_data["undo"]) undo.emplace_back(QubistString(entry["block"]), QubistList(entry["deltas"]));
+            ledger_data.erase("undo");
+        }
+        seq = checkpoint_seq;
+        rebuild_slots();
+
+        QubistInt replayed = 0;
+        for (const QubistString& path : {retired_path(), journal_path()}) {
+            if (!std::filesystem::exists(path)) continue;
+            replayed += LedgerJournal::replay(path, [this](const QubistDict& record) {
+                uint64_t record_seq = QubistInt(record.at("seq"));
+                if (record_seq <= seq) return;
+                apply(record);
+                seq = record_seq;
+            });
+        }
+        if (seq > checkpoint_seq) {
+            std::cerr << "♻️  Ledger journal: replayed " << (seq - checkpoint_seq) << " of " << replayed
+                      << " records" << std::endl;
+        }
+    }
+
+    // Temp file, fsync and rename: the checkpoint is either the old one or
+    // the new one, and it is on disk before the log it replaces is dropped
+    static qfunc write_checkpoint(const QubistString& path, const QubistDict& data) -> void {
+        QubistString tmp_path = path + ".tmp";
+        std::string text = json::dump(data, 2);
+        int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) throw std::runtime_error("cannot write ledger checkpoint " + tmp_path + ": " + std::strerror(errno));
+        size_t offset = 0;
+        while(offset < text.size()) {
+            ssize_t n = ::write(fd, text.data() + offset, text.size() - offset);
+            if(n < 0 && errno == EINTR) continue;
+            if(n < 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot write ledger checkpoint " + tmp_path + ": " + std::strerror(errno));
+            }
+            offset += size_t(n);
+        }
+        ::fsync(fd);
+        ::close(fd);
+        std::filesystem::rename(tmp_path, path);
+        QubistString dir = std::filesystem::absolute(QubistString(path)).parent_path().string();
+        int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(dir_fd >= 0) {
+            ::fsync(dir_fd);
+            ::close(dir_fd);
+        }
+    }
+
+    // Surfaces a background checkpoint's outcome; a failed one only costs a
+    // longer replay, since its log is kept and extended
+    qfunc finish_compaction() -> void {
+        if (!compaction.valid()) return;
+        try {
+            compaction.get();
+        } catch (const std::exception& e) {
+            std::cout << "[!] Ledger checkpoint failed: " << e.what() << std::endl;
+        }
+    }
+
+    // Retires the log written so far and checkpoints the state it leads to,
+    // in the background unless `wait`
+    qfunc compact(QubistBool wait) -> void {
+        finish_compaction();
+        if (journal) journal->rotate(retired_path());
+        QubistDict data = ledger_data;
+        data["checkpoint_seq"] = seq;
+        QubistList saved_undo;
+        for (const auto& [block, deltas] : undo) saved_undo.push_back(QubistDict{{"block", block}, {"deltas", deltas}});
+        data["undo"] = saved_undo;
+        checkpoint_seq = seq;
+        last_checkpoint = Simulation::now();
+        auto task = [file = ledger_file, retired = retired_path(), data = std::move(data)]() {
+            write_checkpoint(file, data);
+            std::filesystem::remove(retired);
+        };
+        if (wait) task();
+        else compaction = std::async(std::launch::async, std::move(task));
+    }
+
+    qfunc maybe_compact() -> void {
+        uint64_t behind = seq - checkpoint_seq;
+        if (behind < compact_records && Simulation::now() - last_checkpoint < compact_interval) return;
+        if (compaction.valid() && compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        compact(false);
+    }
+
+    // Appends the record, then books it in memory, so a refused append
+    // leaves the ledger as it was. Returns once the record is on disk, so a
+    // mutation that returned survives a crash.
+    qfunc log(QubistDict record) -> void {
+        require_writable();
+        record["seq"] = seq + 1;
+        uint64_t ticket = journal->append(json::dump(record));
+        seq++;
+        apply(record);
+        maybe_compact();
+        journal->sync(ticket);
+    }
+
+    // Shared by the live path and replay, so both book a record identically
+    qfunc apply(const QubistDict& record) -> void {
+        QubistString op = record.at("op");
+        if (op == "credit") credit(record.at("id"), record.at("amount"));
+        else if (op == "credits") credit_all(record.at("deltas"));
+        else if (op == "agent") upsert_agent(record.at("agent"));
+        else if (op == "connect") push_undo(record.at("block"), record.at("deltas"));
+        else if (op == "disconnect") pop_undo(record.at("block"));
+    }
+
+    // Returns whether the agent already existed
+    qfunc upsert_agent(const QubistDict& fields) -> QubistBool {
+        QubistString agent_id = fields.at("id");
+        if (qvariant* existing = find_agent(agent_id)) {
+            for (const auto& [key, value] : fields) (*existing)[key] = value;
+            return true;
+        }
+        QubistDict new_agent = fields;
+        new_agent["balance_btc_mirror"] = 0.0;
+        new_agent["ai_unlocked"] = true;
+        append_agent(new_agent);
+        return false;
+    }
+
+    // Each delta is an [agent id, amount] pair
+    qfunc credit_all(const QubistList& deltas) -> void {
+        for (const auto& entry : deltas) {
+            QubistList delta = entry;
+            credit(delta[0], delta[1]);
+        }
+    }
+
+    // Credits a connected block's deltas and keeps them for undo
+    qfunc push_undo(const QubistString& block, const QubistList& deltas) -> void {
+        credit_all(deltas);
+        undo.emplace_back(block, deltas);
+        if (undo.size() > max_undo) undo.pop_front();
+    }
+
+    // Block of the newest undo record, empty without one
+    qfunc newest_undo() const -> QubistString {
+        return undo.empty() ? "" : undo.back().first;
+    }
+
+    qfunc pop_undo(const QubistString& block) -> QubistBool {
+        if (undo.empty() || undo.back().first != block) return false;
+        const QubistList& deltas = undo.back().second;
+        for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+            QubistList delta = *it;
+            credit(delta[0], -QubistFloat(delta[1]));
+        }
+        undo.pop_back();
+        return true;
+    }
+
+    // First occurrence wins, as the old linear scan did
+    qfunc rebuild_slots() -> void {
+        slots.clear();
+        size_t slot = 0;
+        for (auto& agent : ledger_data["agents"]) slots.try_emplace(QubistString(agent["id"]), slot++);
+    }
+
+    qfunc find_agent(const QubistString& agent_id) -> qvariant* {
+        auto it = slots.find(agent_id);
+        return it == slots.end() ? nullptr : &ledger_data["agents"][it->second];
+    }
+
+    qfunc append_agent(QubistDict agent) -> void {
+        QubistString agent_id = agent["id"];
+        ledger_data["agents"].push_back(agent);
+        slots.try_emplace(agent_id, ledger_data["agents"].size() - 1);
+    }
+
+public:
+    // Loads for reading; nothing is locked or written until open_journal()
+    qfunc QuantumLedger(QubistString file = "agents_ledger.json") : ledger_file(std::move(file)) {
+        load();
+    }
+
+    // Final checkpoint, so the JSON file is current whenever no process has
+    // the ledger open
+    qfunc ~QuantumLedger() {
+        finish_compaction();
+        try {
+            if (!journal) return;
+            if (seq > checkpoint_seq) compact(true);
+            if (seq == checkpoint_seq) std::filesystem::remove(journal_path());
+            journal.reset();
+        } catch (const std::exception& e) {
+            std::cout << "[!] Ledger checkpoint failed: " << e.what() << std::endl;
+        }
+    }
+
+    QuantumLedger(const QuantumLedger&) = delete;
+    QuantumLedger& operator=(const QuantumLedger&) = delete;
+   
+    // Takes the ledger for writing: locks the journal (throwing while
+    // another process holds it), reloads if anything was written since
+    // load(), and checkpoints a fresh ledger or leftover logs. Locked at
+    // startup rather than on the first mutation, so a process that starts
+    // later cannot take the ledger from under this one.
+    qfunc open_journal() -> void {
+        if (journal) return;
+        journal = std::make_unique<LedgerJournal>(journal_path());
+        if (disk_state() != loaded_from) load();
+        QubistBool logs = std::filesystem::exists(retired_path()) || std::filesystem::file_size(journal_path()) > 0;
+        if (fresh || logs) compact(true);
+    }
+
+    qfunc writable() const -> QubistBool { return journal != nullptr; }
+
+    qfunc require_writable() const -> void {
+        if (!journal) throw std::runtime_error("ledger " + ledger_file + " is not open for writing");
+    }
+
+    qfunc has_agent(const QubistString& agent_id) const -> QubistBool {
+        return slots.count(agent_id) > 0;
     }
    
     qfunc add_agent(QubistString agent_id, QubistString name,
@@ -141,28 +1035,9 @@ public:
                     QubistList domains = QubistList{},
                     QubistDict meta = {}) -> QubistBool {
        
-        for (auto& agent : ledger_data["agents"]) {
-            if (agent["id"] == agent_id) {
-                std::cout << "[i] Agent " << agent_id << " already exists. Updating." << std::endl;
-               
-                agent["description"] = description;
-                agent["expertise"] = expertise;
-                agent["neural_networks"] = neural_networks;
-                agent["domain_level"] = domain_level;
-                agent["domains"] = domains;
-                agent["meta"] = meta;
-                agent["name"] = name;
-               
-                save_json(ledger_file, ledger_data);
-                return true;
-            }
-        }
-       
-        QubistDict new_agent = {
+        QubistDict fields = {
             {"id", agent_id},
             {"name", name},
-            {"balance_btc_mirror", 0.0},
-            {"ai_unlocked", true},
             {"description", description},
             {"expertise", expertise},
             {"neural_networks", neural_networks},
@@ -170,113 +1045,4113 @@ public:
             {"domains", domains},
             {"meta", meta}
         };
+        QubistBool existed = has_agent(agent_id);
+        log(QubistDict{{"op", "agent"}, {"agent", fields}});
        
-        ledger_data["agents"].push_back(new_agent);
-        save_json(ledger_file, ledger_data);
-       
-        std::cout << "[+] Agent " << agent_id << " created in the quantum ledger." << std::endl;
+        if (existed) std::cout << "[i] Agent " << agent_id << " already exists. Updating." << std::endl;
+        else std::cout << "[+] Agent " << agent_id << " created in the quantum ledger." << std::endl;
         return true;
     }
    
     qfunc grant_btc(QubistString agent_id, QubistFloat amount) -> QubistBool {
-        for (auto& agent : ledger_data["agents"]) {
-            if (agent["id"] == agent_id) {
-                QubistFloat current = agent["balance_btc_mirror"];
-                agent["balance_btc_mirror"] = current + amount;
-                agent["ai_unlocked"] = true;
-               
-                save_json(ledger_file, ledger_data);
-                return true;
+        if (!has_agent(agent_id)) return false;
+        log(QubistDict{{"op", "credit"}, {"id", agent_id}, {"amount", amount}});
+        return true;
+    }
+
+    // Books a batch of grants as one record: one append and one fdatasync
+    // for the lot instead of one each, and a crash keeps all or none of
+    // them. Grants to unknown agents are skipped; returns how many were booked.
+    qfunc grant_many(const std::vector<std::pair<QubistString, QubistFloat>>& grants) -> QubistInt {
+        QubistList deltas;
+        for (const auto& [agent_id, amount] : grants) {
+            if (has_agent(agent_id)) deltas.push_back(QubistList{agent_id, amount});
+        }
+        if (deltas.empty()) return 0;
+        log(QubistDict{{"op", "credits"}, {"deltas", deltas}});
+        return QubistInt(deltas.size());
+    }
+   
+    // Current balance, or nullopt for an unknown agent
+    qfunc balance_of(QubistString agent_id) -> std::optional<QubistFloat> {
+        qvariant* agent = find_agent(agent_id);
+        if (!agent) return std::nullopt;
+        return QubistFloat((*agent)["balance_btc_mirror"]);
+    }
+   
+    // Books a block's transactions as one journal record. The balance changes
+    // actually made are kept under "undo" (newest last, max_undo blocks) so a
+    // reorg can take them back; blocks that changed nothing leave no record.
+    // A transaction to an unknown agent, or a transfer its sender can no
+    // longer cover, is refused whole, not booked. The block's reward is
+    // paid to `payee` last, less any fee no booked transfer actually paid.
+    // The deltas are worked out first and booked only with their record.
+    // Unsaved bookings (save = false) stay in memory until flush().
+    qfunc connect_block(const Hash256& block, const std::vector<QuantumTransaction>& transactions,
+                        const QubistString& payee, QubistFloat reward, QubistBool save = true) -> void {
+        QubistList deltas;
+        std::unordered_map<QubistString, QubistFloat> moved;     // this block's effect so far
+        for (const auto& tx : transactions) {
+            if (tx.kind != QuantumTransaction::transfer) reward -= tx.fee;
+            if (!has_agent(tx.to)) {
+                std::cout << "[!] Transaction " << tx.id.to_hex().substr(0, 16) << " not booked: no agent "
+                          << tx.to << std::endl;
+                if (tx.kind == QuantumTransaction::transfer) reward -= tx.fee;
+                continue;
             }
+            if (tx.kind == QuantumTransaction::transfer) {
+                auto balance = balance_of(tx.from);
+                if (!balance || *balance + moved[tx.from] < tx.spend()) {
+                    std::cout << "[!] Transfer " << tx.id.to_hex().substr(0, 16) << " not booked: "
+                              << tx.from << " cannot cover " << tx.spend() << std::endl;
+                    reward -= tx.fee;
+                    continue;
+                }
+                moved[tx.from] -= tx.spend();
+                deltas.push_back(QubistList{tx.from, -tx.spend()});
+            }
+            moved[tx.to] += tx.amount;
+            deltas.push_back(QubistList{tx.to, tx.amount});
         }
-        return false;
+        if (reward > 0 && has_agent(payee)) {
+            deltas.push_back(QubistList{payee, reward});
+        } else if (reward > 0) {
+            std::cout << "[!] Reward of block " << block.to_hex().substr(0, 16) << " not booked: no agent "
+                      << payee << std::endl;
+        }
+        if (deltas.empty()) return;
+
+        QubistDict record = {{"op", "connect"}, {"block", block.to_hex()}, {"deltas", deltas}};
+        if (save) log(record);
+        else apply(record);
     }
-};
 
-// ==================== MIRROR BLOCKCHAIN MINER ====================
-class QuantumMiner {
-private:
-    QubistInt current_height = 0;
-    QubistString chain_file = "mirror_chain.jsonl";
-    QubistFloat block_reward = 50.0;
-   
-    qfunc generate_quantum_hash(QubistString data, QubistInt nonce) -> QubistString {
-        // Quantum-inspired hash function (simplified)
-        std::string combined = data + std::to_string(nonce);
-        unsigned char hash[32];
-        SHA256((const unsigned char*)combined.c_str(), combined.length(), hash);
-       
-        char hex_hash[65];
-        for(int i = 0; i < 32; i++) sprintf(hex_hash + (i * 2), "%02x", hash[i]);
-        hex_hash[64] = 0;
-       
-        return "0000" + std::string(hex_hash + 4); // Simplified PoW
+    // Reverses connect_block for the newest connected block. Blocks are taken
+    // off newest first, so a block that booked anything is always on top; the
+    // caller keeps reorgs within max_undo blocks.
+    qfunc disconnect_block(const Hash256& block) -> void {
+        if (newest_undo() == block.to_hex()) log(QubistDict{{"op", "disconnect"}, {"block", block.to_hex()}});
+    }
+
+    static constexpr size_t max_undo = 128;
+    // Checkpoint once the journal is this many records ahead, or this old
+    static constexpr uint64_t compact_records = 65536;
+    static constexpr std::chrono::seconds compact_interval{30};
+
+    // Every agent's balance, sorted by id
+    qfunc balances() -> std::vector<std::pair<QubistString, QubistFloat>> {
+        std::vector<std::pair<QubistString, QubistFloat>> out;
+        for (auto& agent : ledger_data["agents"]) {
+            out.emplace_back(QubistString(agent["id"]), QubistFloat(agent["balance_btc_mirror"]));
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    // Replaces every balance with a snapshot's (agents it lacks drop to 0,
+    // agents only it knows are added bare) and forgets the undo records,
+    // which belonged to the state being replaced. Not saved until flush().
+    qfunc restore_balances(const std::vector<std::pair<QubistString, QubistFloat>>& snapshot) -> void {
+        std::unordered_map<QubistString, QubistFloat> wanted(snapshot.begin(), snapshot.end());
+        for (auto& agent : ledger_data["agents"]) {
+            auto it = wanted.find(QubistString(agent["id"]));
+            agent["balance_btc_mirror"] = it == wanted.end() ? 0.0 : it->second;
+            if (it != wanted.end()) wanted.erase(it);
+        }
+        for (const auto& [id, balance] : snapshot) {
+            if (!wanted.count(id)) continue;
+            append_agent(QubistDict{{"id", id}, {"name", id}, {"balance_btc_mirror", balance}});
+        }
+        undo.clear();
+    }
+
+    // Synchronous checkpoint, including changes the journal never saw
+    qfunc flush() -> void {
+        require_writable();
+        compact(true);
+    }
+
+private:
+    qfunc credit(const QubistString& agent_id, QubistFloat amount) -> QubistBool {
+        qvariant* found = find_agent(agent_id);
+        if (!found) return false;
+        auto& agent = *found;
+        QubistFloat current = agent["balance_btc_mirror"];
+        agent["balance_btc_mirror"] = current + amount;
+        agent["ai_unlocked"] = true;
+        return true;
+    }
+};
+
+// ==================== BINARY BLOCK HEADER ====================
+// Fixed 80-byte header, Bitcoin layout, stored little-endian. These bytes are
+// exactly what gets hashed; the JSON block is only a rendering of them.
+static_assert(std::endian::native == std::endian::little, "header layout assumes a little-endian host");
+
+struct alignas(16) QuantumBlockHeader {
+    uint32_t version = 1;
+    Hash256 previous_hash;
+    Hash256 merkle_root;
+    uint32_t time = 0;
+    uint32_t bits = 0;
+    uint32_t nonce = 0;
+
+    static constexpr size_t nonce_offset = 76;
+
+    qfunc bytes() const -> const uint8_t* { return reinterpret_cast<const uint8_t*>(this); }
+};
+static_assert(sizeof(QuantumBlockHeader) == 80, "block header must stay 80 bytes");
+static_assert(offsetof(QuantumBlockHeader, nonce) == QuantumBlockHeader::nonce_offset);
+
+// ==================== SHA-256 MIDSTATE ENGINE ====================
+// While a block is mined only the nonce changes, so the first 76 header bytes
+// are absorbed once: the first 64-byte block is compressed up front, and so are
+// the leading rounds of the final block whose message words (merkle tail, time,
+// bits) come purely from the fixed prefix.
+namespace Sha256 {
+
+constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+inline qfunc rotr(uint32_t x, int n) -> uint32_t { return (x >> n) | (x << (32 - n)); }
+
+inline qfunc load_be32(const uint8_t* p) -> uint32_t {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline qfunc store_be32(uint8_t* p, uint32_t v) -> void {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+
+// One round on working state s[0..7] = a..h
+inline qfunc round(uint32_t* s, uint32_t k, uint32_t w) -> void {
+    uint32_t t1 = s[7] + (rotr(s[4], 6) ^ rotr(s[4], 11) ^ rotr(s[4], 25)) +
+                  ((s[4] & s[5]) ^ (~s[4] & s[6])) + k + w;
+    uint32_t t2 = (rotr(s[0], 2) ^ rotr(s[0], 13) ^ rotr(s[0], 22)) +
+                  ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+    s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+    s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+}
+
+inline qfunc expand(uint32_t* w, const uint8_t* block) -> void {
+    for(int i = 0; i < 16; i++) w[i] = load_be32(block + 4 * i);
+    for(int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+}
+
+// Runs rounds [first_round, 64) from `working` and feeds the result into `chain`
+inline qfunc compress_from(uint32_t* chain, const uint32_t* working,
+                           int first_round, const uint8_t* block) -> void {
+    uint32_t w[64], s[8];
+    expand(w, block);
+    std::copy(working, working + 8, s);
+    for(int i = first_round; i < 64; i++) round(s, K[i], w[i]);
+    for(int i = 0; i < 8; i++) chain[i] += s[i];
+}
+
+inline qfunc compress(uint32_t* chain, const uint8_t* block) -> void {
+    compress_from(chain, chain, 0, block);
+}
+
+} // namespace Sha256
+
+class QuantumMidstate {
+private:
+    uint32_t chain[8];
+    uint32_t working[8];      // a..h after the prefix-only rounds of the tail block
+    int rounds_done = 0;
+    uint8_t tail[64];
+    size_t tail_len = 0;
+
+public:
+    qfunc QuantumMidstate(const QuantumBlockHeader& header) {
+        const uint8_t* data = header.bytes();
+        std::copy(Sha256::IV, Sha256::IV + 8, chain);
+        size_t offset = 0;
+        for(; offset + 64 <= QuantumBlockHeader::nonce_offset; offset += 64) {
+            Sha256::compress(chain, data + offset);
+        }
+
+        tail_len = QuantumBlockHeader::nonce_offset - offset;
+        std::memcpy(tail, data + offset, tail_len);
+
+        // Rounds 0..n-1 of the tail block only read words W[0..n-1]
+        uint32_t w[16];
+        rounds_done = int(tail_len / 4);
+        for(int i = 0; i < rounds_done; i++) w[i] = Sha256::load_be32(tail + 4 * i);
+        std::copy(chain, chain + 8, working);
+        for(int i = 0; i < rounds_done; i++) Sha256::round(working, Sha256::K[i], w[i]);
+    }
+
+    qfunc chain_state() const -> const uint32_t* { return chain; }
+    qfunc working_state() const -> const uint32_t* { return working; }
+    qfunc prefix_rounds() const -> int { return rounds_done; }
+
+    // Lays out the padded final block for `nonce`
+    qfunc prepare(uint32_t nonce, uint8_t* block) const -> void {
+        std::memset(block, 0, 64);
+        std::memcpy(block, tail, tail_len);
+        std::memcpy(block + tail_len, &nonce, sizeof(nonce));
+        block[tail_len + 4] = 0x80;
+        uint64_t bit_len = sizeof(QuantumBlockHeader) * 8;
+        for(int i = 0; i < 8; i++) block[63 - i] = uint8_t(bit_len >> (8 * i));
+    }
+
+    // SHA256(header with `nonce`), bit-identical to hashing all 80 bytes
+    qfunc hash(uint32_t nonce, uint8_t* out) const -> void {
+        uint8_t block[64];
+        prepare(nonce, block);
+
+        uint32_t state[8];
+        std::copy(chain, chain + 8, state);
+        Sha256::compress_from(state, working, rounds_done, block);
+
+        for(int i = 0; i < 8; i++) Sha256::store_be32(out + 4 * i, state[i]);
+    }
+};
+
+// ==================== MULTI-BUFFER HASH KERNELS ====================
+// Each kernel compresses `lanes` independent tail blocks against one shared
+// midstate per call. The best kernel for the host is picked once by a short
+// calibration run; the scalar kernel is the bit-exact reference for all others.
+namespace HashKernels {
+
+struct Kernel {
+    const char* name;
+    unsigned lanes;
+    // blocks: lanes * 64 bytes, states: lanes * 8 words (chain already added)
+    void (*compress)(const uint32_t* chain, const uint32_t* working, int first_round,
+                     const uint8_t* blocks, uint32_t* states);
+};
+
+static qfunc compress_scalar(const uint32_t* chain, const uint32_t* working, int first_round,
+                             const uint8_t* blocks, uint32_t* states) -> void {
+    std::copy(chain, chain + 8, states);
+    Sha256::compress_from(states, working, first_round, blocks);
+}
+
+// Lane-parallel rounds written with GCC vector extensions, so one body serves
+// every register width; the target attribute on each entry point decides the ISA.
+template <typename V>
+[[gnu::always_inline]] inline qfunc vrotr(V x, int n) -> V { return (x >> n) | (x << (32 - n)); }
+
+template <typename V, unsigned Lanes>
+[[gnu::always_inline]] inline qfunc compress_vector(const uint32_t* chain, const uint32_t* working,
+                                                    int first_round, const uint8_t* blocks,
+                                                    uint32_t* states) -> void {
+    V w[64];
+    for(int i = 0; i < 16; i++) {
+        for(unsigned l = 0; l < Lanes; l++) w[i][l] = Sha256::load_be32(blocks + l * 64 + 4 * i);
+    }
+    for(int i = 16; i < 64; i++) {
+        V s0 = vrotr(w[i - 15], 7) ^ vrotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        V s1 = vrotr(w[i - 2], 17) ^ vrotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    V s[8];
+    for(int i = 0; i < 8; i++) s[i] = V{} + working[i];
+    for(int i = first_round; i < 64; i++) {
+        V t1 = s[7] + (vrotr(s[4], 6) ^ vrotr(s[4], 11) ^ vrotr(s[4], 25)) +
+               ((s[4] & s[5]) ^ (~s[4] & s[6])) + Sha256::K[i] + w[i];
+        V t2 = (vrotr(s[0], 2) ^ vrotr(s[0], 13) ^ vrotr(s[0], 22)) +
+               ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+        s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+    }
+
+    for(unsigned l = 0; l < Lanes; l++) {
+        for(int i = 0; i < 8; i++) states[l * 8 + i] = chain[i] + s[i][l];
+    }
+}
+
+qtype U32x8 = uint32_t __attribute__((vector_size(32)));
+qtype U32x16 = uint32_t __attribute__((vector_size(64)));
+
+__attribute__((target("avx2")))
+static qfunc compress_avx2(const uint32_t* chain, const uint32_t* working, int first_round,
+                           const uint8_t* blocks, uint32_t* states) -> void {
+    compress_vector<U32x8, 8>(chain, working, first_round, blocks, states);
+}
+
+__attribute__((target("avx512f")))
+static qfunc compress_avx512(const uint32_t* chain, const uint32_t* working, int first_round,
+                             const uint8_t* blocks, uint32_t* states) -> void {
+    compress_vector<U32x16, 16>(chain, working, first_round, blocks, states);
+}
+
+// SHA extensions work in groups of four rounds, so this kernel always runs the
+// full 64 rounds from the chaining value; the result is the same.
+__attribute__((target("sha,sse4.1")))
+static qfunc compress_shani_one(const uint32_t* chain, const uint8_t* block, uint32_t* out) -> void {
+    const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&chain[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&chain[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);       // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);            // CDGH
+    const __m128i abef = state0, cdgh = state1;
+
+    __m128i m[16];
+    for(int g = 0; g < 16; g++) {
+        if(g < 4) {
+            m[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 16 * g)), byteswap);
+        } else {
+            __m128i t = _mm_sha256msg1_epu32(m[g - 4], m[g - 3]);
+            t = _mm_add_epi32(t, _mm_alignr_epi8(m[g - 1], m[g - 2], 4));
+            m[g] = _mm_sha256msg2_epu32(t, m[g - 1]);
+        }
+        __m128i msg = _mm_add_epi32(m[g], _mm_loadu_si128((const __m128i*)&Sha256::K[4 * g]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+    tmp = _mm_shuffle_epi32(state0, 0x1B);                  // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);               // DCHG
+    _mm_storeu_si128((__m128i*)&out[0], _mm_blend_epi16(tmp, state1, 0xF0));   // DCBA
+    _mm_storeu_si128((__m128i*)&out[4], _mm_alignr_epi8(state1, tmp, 8));      // HGFE
+}
+
+__attribute__((target("sha,sse4.1")))
+static qfunc compress_shani(const uint32_t* chain, const uint32_t*, int,
+                            const uint8_t* blocks, uint32_t* states) -> void {
+    // Two independent blocks back to back keep both SHA units busy
+    compress_shani_one(chain, blocks, states);
+    compress_shani_one(chain, blocks + 64, states + 8);
+}
+
+static qfunc cpu_has_sha() -> bool {
+    unsigned eax, ebx, ecx, edx;
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return (ebx & bit_SHA) && __builtin_cpu_supports("sse4.1");
+}
+
+// Every kernel this CPU can execute, verified or not
+static qfunc supported() -> std::vector<Kernel> {
+    std::vector<Kernel> kernels = {{"scalar", 1, compress_scalar}};
+    if(__builtin_cpu_supports("avx2")) kernels.push_back({"avx2", 8, compress_avx2});
+    if(__builtin_cpu_supports("avx512f")) kernels.push_back({"avx512", 16, compress_avx512});
+    if(cpu_has_sha()) kernels.push_back({"shani", 2, compress_shani});
+    return kernels;
+}
+
+// Hashes nonces [first, first + kernel.lanes)
+static qfunc hash_batch(const Kernel& kernel, const QuantumMidstate& midstate,
+                        uint32_t first, uint8_t* digests) -> void {
+    alignas(64) uint8_t blocks[16 * 64];
+    uint32_t states[16 * 8];
+
+    for(unsigned l = 0; l < kernel.lanes; l++) midstate.prepare(first + l, blocks + 64 * l);
+    kernel.compress(midstate.chain_state(), midstate.working_state(), midstate.prefix_rounds(),
+                    blocks, states);
+    for(unsigned l = 0; l < kernel.lanes; l++) {
+        for(int i = 0; i < 8; i++) Sha256::store_be32(digests + 32 * l + 4 * i, states[l * 8 + i]);
+    }
+}
+
+// Known answer: the Bitcoin genesis header, whose double SHA-256 is fixed.
+// Every lane of a batch around the genesis nonce must match a one-shot SHA-256
+// of the same header, and the genesis lane must double-hash to the known digest.
+static qfunc agrees(const Kernel& kernel) -> bool {
+    QuantumBlockHeader header;
+    header.merkle_root = Hash256::from_hex("3ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a");
+    header.time = 1231006505;
+    header.bits = 0x1d00ffff;
+    const uint32_t genesis_nonce = 2083236893;
+    const Hash256 genesis = Hash256::from_hex("6fe28c0ab6f1b372c1a6a246ae63f74f931e8365e15a089c68d6190000000000");
+
+    QuantumMidstate midstate(header);
+    for(uint32_t first : {genesis_nonce - kernel.lanes + 1, genesis_nonce}) {
+        alignas(64) uint8_t digests[16 * 32];
+        hash_batch(kernel, midstate, first, digests);
+        for(unsigned l = 0; l < kernel.lanes; l++) {
+            header.nonce = first + l;
+            Hash256 expected = Hash256::of(header.bytes(), sizeof(QuantumBlockHeader));
+            if(std::memcmp(digests + 32 * l, expected.data(), 32) != 0) return false;
+            if(header.nonce == genesis_nonce && Hash256::of(digests + 32 * l, 32) != genesis) return false;
+        }
+    }
+    return true;
+}
+
+// Kernels that passed the known-answer check; only these can be selected
+static qfunc available() -> const std::vector<Kernel>& {
+    static const std::vector<Kernel> verified = [] {
+        std::vector<Kernel> kernels;
+        for(const auto& kernel : supported()) {
+            if(agrees(kernel)) kernels.push_back(kernel);
+            else std::cerr << "⚠️ Hash kernel " << kernel.name << " fails its known-answer check, disabled" << std::endl;
+        }
+        return kernels;
+    }();
+    return verified;
+}
+
+// Hashes dummy tails for a couple of milliseconds per kernel and keeps the fastest
+static qfunc calibrate() -> Kernel {
+    const std::vector<Kernel>& kernels = available();
+    if(kernels.empty()) throw std::runtime_error("no hash kernel passes its known-answer check");
+    uint32_t chain[8], states[16 * 8];
+    std::copy(Sha256::IV, Sha256::IV + 8, chain);
+    uint8_t blocks[16 * 64] = {0};
+
+    Kernel best = kernels.front();
+    double best_rate = 0.0;
+    for(const auto& kernel : kernels) {
+        QubistInt hashed = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>::zero();
+        while(elapsed < std::chrono::milliseconds(2)) {
+            for(int i = 0; i < 64; i++) {
+                blocks[0] = uint8_t(i);
+                kernel.compress(chain, chain, 0, blocks, states);
+            }
+            hashed += 64 * kernel.lanes;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        double rate = hashed / elapsed.count();
+        if(rate > best_rate) { best_rate = rate; best = kernel; }
+    }
+    return best;
+}
+
+static qfunc best() -> const Kernel& {
+    static const Kernel selected = calibrate();
+    return selected;
+}
+
+static qfunc by_name(const QubistString& name) -> Kernel {
+    if(name == "auto") return best();
+    for(const auto& kernel : available()) {
+        if(name == kernel.name) return kernel;
+    }
+    throw std::invalid_argument("hash kernel not available on this CPU: " + name);
+}
+
+} // namespace HashKernels
+
+// ==================== COMPACT DIFFICULTY TARGETS ====================
+// nBits-style targets: the top byte is a base-256 exponent and the low 23 bits
+// a mantissa. A digest, read as a big-endian 256-bit number, meets the target
+// when it is <= mantissa * 256^(exponent - 3).
+
+// Expected hash count behind a block or chain, as a 128-bit integer kept in
+// two words so index entries stay 8-byte aligned
+struct ChainWork {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    constexpr qfunc operator<=>(const ChainWork&) const = default;
+
+    constexpr qfunc operator+(const ChainWork& other) const -> ChainWork {
+        uint64_t sum = low + other.low;
+        return ChainWork{high + other.high + (sum < low), sum};
+    }
+
+    qfunc log2() const -> QubistFloat {
+        return std::log2(std::ldexp(QubistFloat(high), 64) + QubistFloat(low));
+    }
+};
+
+class QuantumTarget {
+private:
+    uint8_t target[32] = {0};   // big-endian
+    uint32_t head = 0;          // first four target bytes, for the fast reject
+    uint32_t compact = 0;
+
+    // Largest compact value not above the big-endian number in `value`
+    static qfunc encode(const uint8_t* value) -> uint32_t {
+        int size = 32;
+        while(size > 0 && value[32 - size] == 0) size--;
+
+        uint32_t mantissa = 0;
+        for(int i = 0; i < 3; i++) {
+            int idx = 32 - size + i;
+            mantissa = (mantissa << 8) | (idx < 32 ? value[idx] : 0);
+        }
+        if(mantissa & 0x00800000) {
+            mantissa >>= 8;
+            size++;
+        }
+        return (uint32_t(size) << 24) | mantissa;
+    }
+
+public:
+    static qfunc from_compact(uint32_t bits) -> QuantumTarget {
+        if(bits & 0x00800000) throw std::invalid_argument("negative compact target");
+
+        QuantumTarget t;
+        t.compact = bits;
+        int size = int(bits >> 24);
+        uint32_t mantissa = bits & 0x007fffff;
+        for(int i = 0; i < 3; i++) {
+            uint8_t byte = uint8_t(mantissa >> (16 - 8 * i));
+            int idx = 32 - size + i;
+            if(idx < 0 && byte != 0) throw std::invalid_argument("compact target overflows 256 bits");
+            if(idx >= 0 && idx < 32) t.target[idx] = byte;
+        }
+        t.head = Sha256::load_be32(t.target);
+        return t;
+    }
+
+    // Digest must start with `zero_bits` zero bits (2^(256 - n) - 1, rounded down)
+    static qfunc from_zero_bits(unsigned zero_bits) -> QuantumTarget {
+        if(zero_bits == 0 || zero_bits > 255) throw std::invalid_argument("zero bits must be in 1..255");
+        uint8_t value[32];
+        for(unsigned i = 0; i < 32; i++) {
+            unsigned bit = 8 * i;
+            value[i] = bit + 8 <= zero_bits ? 0x00 : bit >= zero_bits ? 0xff : uint8_t(0xff >> (zero_bits - bit));
+        }
+        return from_compact(encode(value));
+    }
+
+    // Legacy difficulty: number of leading zero hex digits
+    static qfunc from_hex_zeros(QubistInt difficulty) -> QuantumTarget {
+        return from_zero_bits(unsigned(difficulty * 4));
+    }
+
+    qfunc bits() const -> uint32_t { return compact; }
+
+    qfunc log2_target() const -> QubistFloat {
+        uint32_t mantissa = compact & 0x007fffff;
+        if(mantissa == 0) return 0.0;
+        return std::log2(QubistFloat(mantissa)) + 8.0 * (int(compact >> 24) - 3);
+    }
+
+    // Expected hashes to meet this target, as log2
+    qfunc log2_work() const -> QubistFloat {
+        return 256.0 - log2_target();
+    }
+
+    // 2^256 / target, exact for any target a block can meet; absurdly hard
+    // targets saturate at 2^127
+    qfunc work() const -> ChainWork {
+        uint32_t mantissa = compact & 0x007fffff;
+        int shift = 256 - 8 * (int(compact >> 24) - 3);
+        if(mantissa == 0 || shift > 127) return ChainWork{uint64_t(1) << 63, 0};
+        if(shift < 0) return ChainWork{0, 1};
+        unsigned __int128 work = (unsigned __int128)(1) << shift;
+        work = std::max<unsigned __int128>(work / mantissa, 1);
+        return ChainWork{uint64_t(work >> 64), uint64_t(work)};
+    }
+
+    // Equivalent count of leading zero hex digits, fractional for non-nibble targets
+    qfunc difficulty() const -> QubistFloat {
+        return log2_work() / 4.0;
+    }
+
+    // Target multiplied by `factor` (>1 is easier), kept within (2^8, 2^256)
+    qfunc scaled(QubistFloat factor) const -> QuantumTarget {
+        QubistFloat log2_value = std::clamp(log2_target() + std::log2(factor), 8.0, 255.99);
+        int size = int(log2_value / 8) + 1;
+        // Rounded, so scaled(1.0) keeps the bits it started from
+        auto mantissa = uint32_t(std::min(std::lround(std::exp2(log2_value - 8.0 * (size - 3))), 0xffffffL));
+        if(mantissa & 0x00800000) {
+            mantissa >>= 8;
+            size++;
+        }
+        return from_compact((uint32_t(size) << 24) | mantissa);
+    }
+
+    qfunc head_word() const -> uint32_t { return head; }
+
+    qfunc met_by(const uint8_t* digest) const -> bool {
+        uint32_t digest_head = Sha256::load_be32(digest);
+        if(digest_head != head) return digest_head < head;
+        return std::memcmp(digest + 4, target + 4, 28) <= 0;
+    }
+};
+
+// ==================== HASH & TARGET POLICIES ====================
+// The block hash and the per-batch target test are compile-time policies, so
+// every (hash, check) pairing gets its own fully inlined search loop. The CLI
+// picks a pairing once; nothing is dispatched per nonce.
+namespace HashPolicy {
+
+// Plain SHA-256 of the 80-byte header (this chain's default)
+struct Sha256Single {
+    static constexpr const char* name = "sha256";
+    static constexpr bool uses_midstate = true;
+
+    static inline qfunc finish(uint8_t*) -> void {}
+
+    static inline qfunc hash(const QuantumBlockHeader& header, uint8_t* out) -> void {
+        SHA256(header.bytes(), sizeof(QuantumBlockHeader), out);
+    }
+};
+
+// SHA-256 applied twice, Bitcoin style; the midstate kernels supply the inner hash
+struct Sha256Double {
+    static constexpr const char* name = "sha256d";
+    static constexpr bool uses_midstate = true;
+
+    // Outer hash of a 32-byte digest: one padded block
+    static inline qfunc finish(uint8_t* digest) -> void {
+        uint8_t block[64] = {0};
+        std::memcpy(block, digest, 32);
+        block[32] = 0x80;
+        block[62] = 0x01;           // message length: 256 bits
+        uint32_t chain[8];
+        std::copy(Sha256::IV, Sha256::IV + 8, chain);
+        Sha256::compress(chain, block);
+        for(int i = 0; i < 8; i++) Sha256::store_be32(digest + 4 * i, chain[i]);
+    }
+
+    static inline qfunc hash(const QuantumBlockHeader& header, uint8_t* out) -> void {
+        SHA256(header.bytes(), sizeof(QuantumBlockHeader), out);
+        finish(out);
+    }
+};
+
+// Non-cryptographic 64-bit mixing, for exercising the pipeline at high
+// block rates in tests. Never use it for a real chain.
+struct Fast {
+    static constexpr const char* name = "fast";
+    static constexpr bool uses_midstate = false;
+
+    static inline qfunc finish(uint8_t*) -> void {}
+
+    static inline qfunc hash(const QuantumBlockHeader& header, uint8_t* out) -> void {
+        uint64_t words[10];
+        std::memcpy(words, header.bytes(), sizeof(words));
+        for(uint64_t lane = 0; lane < 4; lane++) {
+            uint64_t h = 0x9e3779b97f4a7c15ull * (lane + 1);
+            for(uint64_t w : words) {
+                h = (h ^ w) * 0xff51afd7ed558ccdull;
+                h ^= h >> 32;
+            }
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            std::memcpy(out + 8 * lane, &h, 8);
+        }
+    }
+};
+
+} // namespace HashPolicy
+
+namespace TargetCheck {
+
+// met_by on each lane in order
+struct Exact {
+    static constexpr const char* name = "exact";
+
+    static inline qfunc first_hit(const QuantumTarget& target, const uint8_t* digests, unsigned lanes) -> unsigned {
+        for(unsigned l = 0; l < lanes; l++) {
+            if(target.met_by(digests + 32 * l)) return l;
+        }
+        return lanes;
+    }
+};
+
+// Compares every lane's leading word in one branch-free pass and runs the
+// full 256-bit compare only for the rare survivors
+struct HeadWord {
+    static constexpr const char* name = "headword";
+
+    static inline qfunc first_hit(const QuantumTarget& target, const uint8_t* digests, unsigned lanes) -> unsigned {
+        uint32_t head = target.head_word();
+        uint32_t candidates = 0;
+        for(unsigned l = 0; l < lanes; l++) {
+            candidates |= uint32_t(Sha256::load_be32(digests + 32 * l) <= head) << l;
+        }
+        while(candidates) {
+            unsigned l = unsigned(std::countr_zero(candidates));
+            if(target.met_by(digests + 32 * l)) return l;
+            candidates &= candidates - 1;
+        }
+        return lanes;
+    }
+};
+
+} // namespace TargetCheck
+
+// Calls fn.template operator()<Policy>() for the named policy
+template <typename Fn>
+static qfunc with_hash_policy(const QubistString& name, Fn&& fn) -> decltype(auto) {
+    if(name == HashPolicy::Sha256Single::name) return fn.template operator()<HashPolicy::Sha256Single>();
+    if(name == HashPolicy::Sha256Double::name) return fn.template operator()<HashPolicy::Sha256Double>();
+    if(name == HashPolicy::Fast::name) return fn.template operator()<HashPolicy::Fast>();
+    throw std::invalid_argument("unknown chain hash: " + name);
+}
+
+template <typename Fn>
+static qfunc with_target_check(const QubistString& name, Fn&& fn) -> decltype(auto) {
+    if(name == TargetCheck::Exact::name) return fn.template operator()<TargetCheck::Exact>();
+    if(name == TargetCheck::HeadWord::name) return fn.template operator()<TargetCheck::HeadWord>();
+    throw std::invalid_argument("unknown target check: " + name);
+}
+
+// ==================== DIFFICULTY RETARGETING ====================
+// Estimates hashrate from the work and search time of the last `window`
+// blocks and picks the target whose expected work takes `target_block_time`
+// at that rate. Each step is clamped to `max_factor` either way so one lucky
+// block cannot swing the chain.
+class DifficultyRetarget {
+private:
+    QubistFloat target_block_time = 10.0;
+    size_t window = 16;
+    QubistFloat max_factor = 4.0;
+    std::deque<std::pair<QubistFloat, QubistFloat>> samples;    // (work, seconds)
+    QubistFloat work_sum = 0.0;
+    QubistFloat time_sum = 0.0;
+
+public:
+    qfunc DifficultyRetarget() = default;
+
+    qfunc DifficultyRetarget(QubistFloat block_time, QubistInt window_size, QubistFloat max_adjustment)
+        : target_block_time(block_time), window(size_t(std::max<QubistInt>(1, window_size))),
+          max_factor(std::max(1.0, max_adjustment)) {}
+
+    qfunc record(const QuantumTarget& target, QubistFloat seconds) -> void {
+        QubistFloat work = std::exp2(target.log2_work());
+        samples.emplace_back(work, seconds);
+        work_sum += work;
+        time_sum += seconds;
+        if(samples.size() > window) {
+            work_sum -= samples.front().first;
+            time_sum -= samples.front().second;
+            samples.pop_front();
+        }
+    }
+
+    // Window length in blocks
+    qfunc span() const -> size_t { return window; }
+
+    qfunc reset() -> void {
+        samples.clear();
+        work_sum = time_sum = 0.0;
+    }
+
+    qfunc next(const QuantumTarget& current) const -> QuantumTarget {
+        if(samples.empty()) return current;
+        QubistFloat hashrate = work_sum / std::max(time_sum, 1e-6);
+        QubistFloat desired_log2_work = std::log2(std::max(hashrate * target_block_time, 1.0));
+        QubistFloat step = std::clamp(current.log2_work() - desired_log2_work,
+                                      -std::log2(max_factor), std::log2(max_factor));
+        return current.scaled(std::exp2(step));
+    }
+};
+
+// ==================== MINING TELEMETRY ====================
+// Miner counters live in a small file-backed shared mapping
+// (data/miner_stats.shm), so `satoshi_mirror stats` can read a running miner
+// with no IPC and no extra work on the mining side. Every counter sits on its
+// own cache line and each hashing thread only ever writes its own slot.
+namespace Telemetry {
+
+enum Phase { phase_template, phase_search, phase_serialize, phase_append, phase_count };
+constexpr const char* phase_names[phase_count] = {"template", "search", "serialize", "append"};
+
+constexpr uint32_t magic = 0x54534d51;          // "QMST"
+constexpr unsigned max_threads = 256;
+constexpr unsigned histogram_buckets = 24;      // bucket k: time-to-block in [2^(k-1), 2^k) ms
+
+struct alignas(64) Counter {
+    std::atomic<uint64_t> value{0};
+};
+
+struct alignas(64) PhaseCounter {
+    std::atomic<uint64_t> ns{0};
+    std::atomic<uint64_t> count{0};
+};
+
+struct SharedStats {
+    uint32_t magic = Telemetry::magic;
+    uint32_t threads = 0;
+    int32_t pid = 0;
+    std::atomic<int64_t> started_ms{0};
+    std::atomic<int64_t> updated_ms{0};
+    Counter thread_hashes[max_threads];
+    Counter blocks;
+    Counter nonces;                 // winning nonce positions, summed
+    PhaseCounter phases[phase_count];
+    Counter time_to_block[histogram_buckets];
+};
+
+} // namespace Telemetry
+
+class MiningTelemetry {
+private:
+    Telemetry::SharedStats* stats = nullptr;
+    bool owner = false;
+    int lock_fd = -1;               // owner: flock()ed while mining; reader: probed for that lock
+
+    qfunc MiningTelemetry(Telemetry::SharedStats* mapped, bool writable, int fd = -1)
+        : stats(mapped), owner(writable), lock_fd(fd) {}
+
+public:
+    static constexpr const char* default_path = "data/miner_stats.shm";
+
+    // Fresh, zeroed counters for this miner process. The file is locked
+    // before it is truncated, so a second miner is refused instead of
+    // shrinking a live mapping under the first.
+    static qfunc create(const QubistString& path, unsigned threads) -> std::unique_ptr<MiningTelemetry> {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0) throw std::runtime_error("cannot create telemetry file " + path);
+        if(::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(fd);
+            throw std::runtime_error("telemetry file " + path + " is in use by another miner");
+        }
+        if(::ftruncate(fd, 0) != 0 || ::ftruncate(fd, sizeof(Telemetry::SharedStats)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot create telemetry file " + path);
+        }
+        void* map = ::mmap(nullptr, sizeof(Telemetry::SharedStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(map == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map telemetry file " + path);
+        }
+
+        auto* shared = new (map) Telemetry::SharedStats();
+        shared->threads = std::min(threads, Telemetry::max_threads);
+        shared->pid = int32_t(::getpid());
+        shared->started_ms = Simulation::unix_ms();
+        shared->updated_ms = Simulation::unix_ms();
+        return std::unique_ptr<MiningTelemetry>(new MiningTelemetry(shared, true, fd));
+    }
+
+    // Read-only view of another (or a finished) miner's counters
+    static qfunc open(const QubistString& path) -> std::unique_ptr<MiningTelemetry> {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) return nullptr;
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Telemetry::SharedStats)) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* map = ::mmap(nullptr, sizeof(Telemetry::SharedStats), PROT_READ, MAP_SHARED, fd, 0);
+        if(map == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        auto* shared = static_cast<Telemetry::SharedStats*>(map);
+        if(shared->magic != Telemetry::magic) {
+            ::munmap(map, sizeof(Telemetry::SharedStats));
+            ::close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<MiningTelemetry>(new MiningTelemetry(shared, false, fd));
+    }
+
+    // A miner holds its file's lock for as long as it runs, so a shared lock
+    // that cannot be had means one is running. Unlike probing the saved pid,
+    // this cannot mistake an unrelated process that reused the pid.
+    qfunc miner_running() const -> bool {
+        if(owner) return true;
+        if(::flock(lock_fd, LOCK_SH | LOCK_NB) != 0) return errno == EWOULDBLOCK;
+        ::flock(lock_fd, LOCK_UN);
+        return false;
+    }
+
+    qfunc ~MiningTelemetry() {
+        ::munmap(stats, sizeof(Telemetry::SharedStats));
+        if(lock_fd >= 0) ::close(lock_fd);
+    }
+
+    qfunc thread_hashes() -> Telemetry::Counter* { return stats->thread_hashes; }
+
+    qfunc total_hashes() const -> uint64_t {
+        uint64_t total = 0;
+        for(unsigned i = 0; i < stats->threads; i++) total += stats->thread_hashes[i].value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    qfunc add_phase(Telemetry::Phase phase, std::chrono::steady_clock::duration elapsed) -> void {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        stats->phases[phase].ns.fetch_add(uint64_t(ns), std::memory_order_relaxed);
+        stats->phases[phase].count.fetch_add(1, std::memory_order_relaxed);
+        stats->updated_ms.store(Simulation::unix_ms(), std::memory_order_relaxed);
+    }
+
+    // Absolute totals owned by another component (the chain writer's flushes)
+    qfunc set_phase(Telemetry::Phase phase, uint64_t ns, uint64_t count) -> void {
+        stats->phases[phase].ns.store(ns, std::memory_order_relaxed);
+        stats->phases[phase].count.store(count, std::memory_order_relaxed);
+    }
+
+    qfunc record_block(QubistInt nonces, QubistFloat seconds) -> void {
+        stats->blocks.value.fetch_add(1, std::memory_order_relaxed);
+        stats->nonces.value.fetch_add(uint64_t(nonces), std::memory_order_relaxed);
+        auto ms = uint64_t(seconds * 1000.0);
+        unsigned bucket = ms == 0 ? 0 : std::min<unsigned>(Telemetry::histogram_buckets - 1,
+                                                           unsigned(std::bit_width(ms)));
+        stats->time_to_block[bucket].value.fetch_add(1, std::memory_order_relaxed);
+        stats->updated_ms.store(Simulation::unix_ms(), std::memory_order_relaxed);
+    }
+
+    qfunc to_json() const -> QubistDict {
+        QubistFloat search_s = stats->phases[Telemetry::phase_search].ns.load() / 1e9;
+        uint64_t blocks = stats->blocks.value.load();
+
+        QubistList per_thread;
+        uint64_t total = 0;
+        for(unsigned i = 0; i < stats->threads; i++) {
+            uint64_t hashes = stats->thread_hashes[i].value.load(std::memory_order_relaxed);
+            total += hashes;
+            per_thread.push_back(search_s > 0 ? hashes / search_s : 0.0);
+        }
+
+        QubistDict phases;
+        for(int p = 0; p < Telemetry::phase_count; p++) {
+            uint64_t ns = stats->phases[p].ns.load(), count = stats->phases[p].count.load();
+            phases[Telemetry::phase_names[p]] = QubistDict{
+                {"total_s", ns / 1e9},
+                {"avg_ms", count ? ns / 1e6 / count : 0.0},
+                {"count", QubistInt(count)}
+            };
+        }
+
+        QubistList histogram;
+        for(unsigned b = 0; b < Telemetry::histogram_buckets; b++) {
+            histogram.push_back(QubistInt(stats->time_to_block[b].value.load()));
+        }
+
+        return QubistDict{
+            {"pid", QubistInt(stats->pid)},
+            {"running", miner_running()},
+            {"started_ms", QubistInt(stats->started_ms.load())},
+            {"updated_ms", QubistInt(stats->updated_ms.load())},
+            {"blocks", QubistInt(blocks)},
+            {"total_hashes", QubistInt(total)},
+            {"hashrate", search_s > 0 ? total / search_s : 0.0},
+            {"thread_hashrate", per_thread},
+            {"nonces_per_block", blocks ? QubistFloat(stats->nonces.value.load()) / blocks : 0.0},
+            {"hashes_per_block", blocks ? QubistFloat(total) / blocks : 0.0},
+            {"phases", phases},
+            {"time_to_block_log2ms", histogram}
+        };
+    }
+
+    qfunc print() const -> void {
+        QubistDict s = to_json();
+        std::cout << "📈 QUANTUM MINER STATS (pid " << s["pid"] << (s["running"] ? ", running" : ", stopped") << ")" << std::endl;
+        std::cout << "   Blocks: " << s["blocks"] << " | Hashrate: " << QubistFloat(s["hashrate"]) / 1e6 << " MH/s" << std::endl;
+        std::cout << "   Nonces/block: " << s["nonces_per_block"] << " | Hashes/block: " << s["hashes_per_block"] << std::endl;
+        for(unsigned i = 0; i < stats->threads; i++) {
+            std::cout << "   Thread " << i << ": " << QubistFloat(s["thread_hashrate"][i]) / 1e6 << " MH/s" << std::endl;
+        }
+        for(int p = 0; p < Telemetry::phase_count; p++) {
+            std::cout << "   " << Telemetry::phase_names[p] << ": avg "
+                      << s["phases"][Telemetry::phase_names[p]]["avg_ms"] << "ms" << std::endl;
+        }
+        std::cout << "   Time-to-block histogram (ms):" << std::endl;
+        for(unsigned b = 0; b < Telemetry::histogram_buckets; b++) {
+            uint64_t count = stats->time_to_block[b].value.load();
+            if(!count) continue;
+            std::cout << "     < " << (uint64_t(1) << b) << "\t" << std::string(std::min<uint64_t>(count, 60), '#')
+                      << " " << count << std::endl;
+        }
+    }
+};
+
+// ==================== THREAD PLACEMENT ====================
+// CPU topology comes from sysfs, limited to the CPUs this process may use.
+// Hashing workers each get their own physical core, and a core's SMT
+// sibling is used only once every core is busy. I/O and background threads
+// run on a separate core, so they never preempt a hashing worker. Worker
+// buffers sit on the worker's own stack and are first touched after
+// pinning, so Linux's first-touch policy puts them on the worker's NUMA
+// node with no libnuma needed.
+namespace Placement {
+
+struct Cpu {
+    int id = 0;
+    int package = 0;
+    int core = 0;
+    int node = 0;
+    int thread = 0;     // SMT position within its core; 0 is the first sibling
+};
+
+struct Topology {
+    std::vector<Cpu> cpus;          // the CPUs we may run on, by id
+    std::vector<int> hashing;       // first siblings of every hashing core, then second siblings, ...
+    std::vector<int> io;            // every sibling of the reserved core
+    unsigned cores = 0;
+    unsigned hashing_cores = 0;
+    unsigned nodes = 0;
+
+    static qfunc read_int(const std::filesystem::path& path, int fallback) -> int {
+        std::ifstream in(path);
+        int value = fallback;
+        return in >> value ? value : fallback;
+    }
+
+    static qfunc detect() -> Topology {
+        Topology topology;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return topology;
+
+        for(int id = 0; id < CPU_SETSIZE; id++) {
+            if(!CPU_ISSET(id, &allowed)) continue;
+            std::filesystem::path dir = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+            Cpu cpu;
+            cpu.id = id;
+            cpu.package = read_int(dir / "topology/physical_package_id", 0);
+            cpu.core = read_int(dir / "topology/core_id", id);
+            std::error_code error;
+            for(const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+                QubistString name = entry.path().filename();
+                if(name.size() > 4 && name.rfind("node", 0) == 0 && std::isdigit(uint8_t(name[4]))) {
+                    cpu.node = std::stoi(name.substr(4));
+                }
+            }
+            topology.cpus.push_back(cpu);
+        }
+        if(topology.cpus.empty()) return topology;
+
+        // Siblings share (package, core); rank them by CPU id
+        std::vector<Cpu*> by_core;
+        for(Cpu& cpu : topology.cpus) by_core.push_back(&cpu);
+        std::stable_sort(by_core.begin(), by_core.end(), [](const Cpu* a, const Cpu* b) {
+            return std::pair(a->package, a->core) < std::pair(b->package, b->core);
+        });
+        std::vector<int> nodes;
+        for(size_t i = 0; i < by_core.size(); i++) {
+            bool same = i > 0 && by_core[i - 1]->package == by_core[i]->package && by_core[i - 1]->core == by_core[i]->core;
+            by_core[i]->thread = same ? by_core[i - 1]->thread + 1 : 0;
+            if(!same) topology.cores++;
+            if(std::find(nodes.begin(), nodes.end(), by_core[i]->node) == nodes.end()) nodes.push_back(by_core[i]->node);
+        }
+        topology.nodes = unsigned(nodes.size());
+
+        // From four cores up, the last core of the first node is kept for I/O
+        std::pair<int, int> reserved{-1, -1};
+        if(topology.cores >= 4) {
+            for(const Cpu& cpu : topology.cpus) {
+                if(cpu.node == topology.cpus.front().node && cpu.thread == 0) reserved = {cpu.package, cpu.core};
+            }
+        }
+        std::vector<Cpu> order;
+        for(const Cpu& cpu : topology.cpus) {
+            if(std::pair(cpu.package, cpu.core) == reserved) topology.io.push_back(cpu.id);
+            else order.push_back(cpu);
+        }
+        // Fill every core of node 0, then node 1, ... before doubling up on siblings
+        std::stable_sort(order.begin(), order.end(), [](const Cpu& a, const Cpu& b) {
+            return std::pair(a.thread, a.node) < std::pair(b.thread, b.node);
+        });
+        for(const Cpu& cpu : order) {
+            topology.hashing.push_back(cpu.id);
+            if(cpu.thread == 0) topology.hashing_cores++;
+        }
+        return topology;
+    }
+};
+
+inline QubistBool active = true;      // --placement off leaves every thread to the scheduler
+
+static qfunc topology() -> const Topology& {
+    static const Topology detected = Topology::detect();
+    return detected;
+}
+
+// Pinning only pays off with more than one physical core to choose from
+static qfunc pinning() -> QubistBool { return active && topology().cores > 1; }
+
+// Default hashing worker count: one per hashing core
+static qfunc hashing_threads() -> unsigned {
+    if(!pinning()) return std::max(1u, std::thread::hardware_concurrency());
+    return std::max(1u, topology().hashing_cores);
+}
+
+static qfunc pin_to(const std::vector<int>& cpus) -> void {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus) CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Background and I/O threads go to the reserved core, when there is one
+static qfunc pin_io() -> void {
+    if(pinning() && !topology().io.empty()) pin_to(topology().io);
+}
+
+// Holds hashing worker `index` on its CPU while in scope, then restores the
+// thread's previous mask (the calling thread doubles as worker #0)
+class HashingSlot {
+private:
+    cpu_set_t saved;
+    bool pinned = false;
+
+public:
+    qfunc HashingSlot(unsigned index) {
+        const Topology& cpus = topology();
+        if(!pinning() || cpus.hashing.empty()) return;
+        pinned = pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0;
+        if(pinned) pin_to({cpus.hashing[index % cpus.hashing.size()]});
+    }
+
+    qfunc ~HashingSlot() {
+        if(pinned) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    }
+
+    HashingSlot(const HashingSlot&) = delete;
+    HashingSlot& operator=(const HashingSlot&) = delete;
+};
+
+static qfunc describe() -> QubistString {
+    const Topology& cpus = topology();
+    if(!active) return "off";
+    if(!pinning()) return "unpinned (" + std::to_string(cpus.cores) + " core)";
+    return std::to_string(cpus.nodes) + " nodes, " + std::to_string(cpus.cores) + " cores: " +
+           std::to_string(cpus.hashing_cores) + " hashing, " + (cpus.io.empty() ? "shared" : "1 reserved") + " for I/O";
+}
+
+} // namespace Placement
+
+// ==================== PARALLEL NONCE SEARCH ====================
+// Workers claim small nonce chunks from a shared cursor, so fast threads just
+// come back for more work instead of idling behind a static split. The lowest
+// winning nonce is kept, which makes the answer identical to a sequential walk.
+class NonceSearch {
+public:
+    static constexpr QubistInt chunk_size = 1024;
+    static constexpr QubistInt poll_interval = 64;
+    static constexpr QubistInt not_found = std::numeric_limits<QubistInt>::max();
+
+    // Knobs an outside governor turns while a search runs, read between
+    // chunks: workers numbered `active` and up park (worker #0 never does),
+    // and the rest sleep off (1 - duty) of their time every pace_window
+    struct Throttle {
+        std::atomic<unsigned> active{std::numeric_limits<unsigned>::max()};
+        std::atomic<QubistFloat> duty{1.0};
+        std::atomic<bool> halted{false};       // stop taking new blocks
+        std::atomic<bool> cancelled{false};    // abandon the current search (its work is stale)
+
+        static constexpr auto pace_window = std::chrono::milliseconds(2);
+
+        qfunc parked(unsigned index) const -> bool {
+            return index > 0 && index >= active.load(std::memory_order_relaxed);
+        }
+
+        qfunc stopped() const -> bool { return cancelled.load(std::memory_order_relaxed); }
+    };
+
+    static qfunc hardware_threads() -> unsigned {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    template <typename Probe>
+    static qfunc run(Probe probe, unsigned workers, QubistInt limit = not_found,
+                     Telemetry::Counter* hash_counters = nullptr, const Throttle* throttle = nullptr) -> QubistInt {
+        return run_batched([&](QubistInt nonce) { return probe(nonce) ? nonce : not_found; },
+                           workers, 1, limit, hash_counters, throttle);
+    }
+
+    // probe(first) checks nonces [first, first + stride) and returns the lowest
+    // hit or not_found. stride must divide poll_interval; the search covers
+    // [0, limit), with limit a multiple of chunk_size. Worker i adds its hash
+    // count to hash_counters[i] once per chunk.
+    template <typename BatchProbe>
+    static qfunc run_batched(BatchProbe probe, unsigned workers, unsigned stride,
+                             QubistInt limit = not_found,
+                             Telemetry::Counter* hash_counters = nullptr,
+                             const Throttle* throttle = nullptr) -> QubistInt {
+        std::atomic<QubistInt> cursor{0};
+        std::atomic<QubistInt> winner{not_found};
+
+        auto worker = [&](unsigned index) {
+            Placement::HashingSlot slot(index);
+            uint64_t hashed = 0;
+            auto flush = [&]() {
+                if(hash_counters) {
+                    hash_counters[index % Telemetry::max_threads].value.fetch_add(hashed, std::memory_order_relaxed);
+                }
+                hashed = 0;
+            };
+            std::chrono::steady_clock::duration busy{};
+
+            while(true) {
+                if(throttle) {
+                    while(throttle->parked(index) && !throttle->stopped() &&
+                          cursor.load(std::memory_order_relaxed) < limit && winner.load(std::memory_order_acquire) == not_found) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                    if(throttle->stopped()) return flush();
+                }
+                QubistFloat duty = throttle ? throttle->duty.load(std::memory_order_relaxed) : 1.0;
+                auto chunk_start = duty < 1.0 ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+                QubistInt begin = cursor.fetch_add(chunk_size, std::memory_order_relaxed);
+                // Chunks past a known winner can never hold a lower nonce
+                if(begin >= limit || begin >= winner.load(std::memory_order_acquire)) return flush();
+
+                for(QubistInt nonce = begin; nonce < begin + chunk_size; nonce += stride) {
+                    if((nonce & (poll_interval - 1)) == 0 &&
+                       (nonce >= winner.load(std::memory_order_relaxed) || (throttle && throttle->stopped()))) return flush();
+
+                    QubistInt hit = probe(nonce);
+                    hashed += stride;
+                    if(hit != not_found) {
+                        QubistInt best = winner.load(std::memory_order_relaxed);
+                        while(hit < best &&
+                              !winner.compare_exchange_weak(best, hit, std::memory_order_acq_rel)) {}
+                        return flush();
+                    }
+                }
+                flush();
+
+                // Rest in whole windows: sub-millisecond sleeps overshoot
+                if(duty < 1.0) {
+                    busy += std::chrono::steady_clock::now() - chunk_start;
+                    if(busy >= Throttle::pace_window) {
+                        std::this_thread::sleep_for(std::chrono::duration<QubistFloat>(busy) * ((1.0 - duty) / duty));
+                        busy = {};
+                    }
+                }
+            }
+        };
+
+        // The calling thread is worker #0
+        std::vector<std::thread> pool;
+        for(unsigned i = 1; i < workers; i++) pool.emplace_back(worker, i);
+        worker(0);
+        for(auto& t : pool) t.join();
+
+        return winner.load();
+    }
+
+    // fn(i) for every i in [0, count), chunks handed out from a shared cursor
+    template <typename Fn>
+    static qfunc for_each_index(size_t count, unsigned workers, Fn fn) -> void {
+        std::atomic<size_t> cursor{0};
+        auto worker = [&](unsigned index) {
+            Placement::HashingSlot slot(index);
+            while(true) {
+                size_t begin = cursor.fetch_add(chunk_size, std::memory_order_relaxed);
+                if(begin >= count) return;
+                size_t end = std::min(count, begin + size_t(chunk_size));
+                for(size_t i = begin; i < end; i++) fn(i);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for(unsigned i = 1; i < workers && size_t(i) * chunk_size < count; i++) pool.emplace_back(worker, i);
+        worker(0);
+        for(auto& t : pool) t.join();
+    }
+};
+
+// ==================== BINARY BLOCK STORE ====================
+// Blocks are kept in rotating segment files (blk00000.dat, blk00001.dat, ...).
+// Each record is 16-byte aligned:
+//   magic "QBLK" | payload length | CRC32C(payload) | 0 | payload | pad | length
+// The trailing length lets the tip be located from the end of the last segment
+// without a scan; readers map segments read-only and walk records in place.
+struct StoredBlock {
+    QuantumBlockHeader header;
+    uint64_t height = 0;
+    Hash256 hash;
+    double mining_time = 0.0;
+    double reward = 0.0;
+    uint64_t reserved = 0;
+};
+static_assert(sizeof(StoredBlock) == 144, "stored block layout changed");
+
+// Miner signature over the block hash, kept as the record's frame extension
+struct BlockSeal {
+    uint8_t public_key[33] = {0};     // compressed secp256k1 point
+    uint8_t signature[64] = {0};      // ECDSA r || s, big-endian
+
+    qfunc bytes() const -> std::string_view {
+        return std::string_view(reinterpret_cast<const char*>(this), sizeof(BlockSeal));
+    }
+
+    static qfunc from_extension(std::string_view extension, BlockSeal& seal) -> bool {
+        if(extension.size() < sizeof(BlockSeal)) return false;
+        std::memcpy(&seal, extension.data(), sizeof(BlockSeal));
+        return true;
+    }
+};
+static_assert(sizeof(BlockSeal) == 97, "block seal layout changed");
+
+// Frame extension: the seal, then the block's transactions back to back
+static qfunc decode_transactions(std::string_view extension, std::vector<QuantumTransaction>& transactions) -> QubistBool {
+    if(extension.size() < sizeof(BlockSeal)) return true;
+    extension.remove_prefix(sizeof(BlockSeal));
+    while(!extension.empty()) {
+        QuantumTransaction tx;
+        if(!QuantumTransaction::decode(extension, tx)) return false;
+        transactions.push_back(std::move(tx));
+    }
+    return true;
+}
+
+// A solved block on its way through the pipeline
+struct SealedBlock {
+    StoredBlock block;
+    BlockSeal seal;
+    std::vector<QuantumTransaction> transactions;
+
+    qfunc extension() const -> std::string {
+        std::string out(seal.bytes());
+        for(const auto& tx : transactions) out += tx.encode();
+        return out;
+    }
+};
+
+namespace BlockStore {
+
+constexpr uint32_t magic = 0x4b4c4251;                  // "QBLK"
+constexpr uint64_t segment_bytes = uint64_t(16) << 20;
+
+// Where a record starts: segment number above bit 40, byte offset below. A
+// single-file store (JSONL) is segment 0.
+constexpr unsigned location_shift = 40;
+
+constexpr qfunc location(uint64_t segment, uint64_t offset) -> uint64_t {
+    return (segment << location_shift) | offset;
+}
+
+constexpr qfunc location_segment(uint64_t at) -> int { return int(at >> location_shift); }
+constexpr qfunc location_offset(uint64_t at) -> uint64_t { return at & ((uint64_t(1) << location_shift) - 1); }
+
+// A record of `record` bytes opens a new segment rather than cross `limit`
+constexpr qfunc rolls_over(uint64_t size, uint64_t record, uint64_t limit) -> bool {
+    return limit && size > 0 && size + record > limit;
+}
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+static qfunc crc32c_table() -> const std::array<uint32_t, 256>& {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82f63b78 & (0u - (c & 1)));
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+__attribute__((target("sse4.2")))
+static qfunc crc32c_hw(const uint8_t* data, size_t len) -> uint32_t {
+    uint64_t crc = 0xffffffff;
+    for(; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for(; len > 0; data++, len--) crc = _mm_crc32_u8(uint32_t(crc), *data);
+    return uint32_t(crc) ^ 0xffffffff;
+}
+
+static qfunc crc32c(const uint8_t* data, size_t len) -> uint32_t {
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    if(hardware) return crc32c_hw(data, len);
+    const auto& table = crc32c_table();
+    uint32_t crc = 0xffffffff;
+    for(size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
+}
+
+static qfunc frame_size(uint32_t payload) -> size_t {
+    return sizeof(FrameHeader) + ((size_t(payload) + 4 + 15) & ~size_t(15));
+}
+
+static qfunc frame(const StoredBlock& block, std::string_view extension = {}) -> QubistString {
+    uint32_t length = uint32_t(sizeof(StoredBlock) + extension.size());
+    QubistString out(frame_size(length), '\0');
+    uint8_t* p = reinterpret_cast<uint8_t*>(out.data());
+
+    std::memcpy(p + sizeof(FrameHeader), &block, sizeof(StoredBlock));
+    std::memcpy(p + sizeof(FrameHeader) + sizeof(StoredBlock), extension.data(), extension.size());
+    FrameHeader head{magic, length, crc32c(p + sizeof(FrameHeader), length), 0};
+    std::memcpy(p, &head, sizeof(head));
+    std::memcpy(p + out.size() - 4, &length, 4);
+    return out;
+}
+
+// Size of the valid record at `p`, or 0 if it is torn or corrupt
+static qfunc check(const uint8_t* p, size_t available) -> size_t {
+    if(available < sizeof(FrameHeader)) return 0;
+    FrameHeader head;
+    std::memcpy(&head, p, sizeof(head));
+    if(head.magic != magic || head.length < sizeof(StoredBlock)) return 0;
+    size_t total = frame_size(head.length);
+    if(total > available) return 0;
+    if(crc32c(p + sizeof(FrameHeader), head.length) != head.crc) return 0;
+    return total;
+}
+
+static qfunc segment_path(const QubistString& directory, int index) -> QubistString {
+    char name[32];
+    std::snprintf(name, sizeof(name), "blk%05d.dat", index);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+static qfunc segment_count(const QubistString& directory) -> int {
+    int count = 0;
+    while(std::filesystem::exists(segment_path(directory, count))) count++;
+    return count;
+}
+
+// Read-only mapping of one segment
+class MappedSegment {
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+
+public:
+    qfunc MappedSegment(const QubistString& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) throw std::runtime_error("cannot open segment " + path);
+        struct stat st;
+        ::fstat(fd, &st);
+        length = size_t(st.st_size);
+        if(length > 0) {
+            void* map = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(map == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map segment " + path);
+            }
+            ::madvise(map, length, MADV_SEQUENTIAL);
+            base = static_cast<const uint8_t*>(map);
+        }
+        ::close(fd);
+    }
+
+    qfunc ~MappedSegment() {
+        if(base) ::munmap(const_cast<uint8_t*>(base), length);
+    }
+
+    MappedSegment(const MappedSegment&) = delete;
+    MappedSegment& operator=(const MappedSegment&) = delete;
+
+    qfunc data() const -> const uint8_t* { return base; }
+    qfunc size() const -> size_t { return length; }
+
+    // Visits records in order from `offset`; fn(block, extension, offset)
+    // returns false to stop. Returns the end offset of the last valid record.
+    template <typename Visitor>
+    qfunc walk(Visitor fn, size_t offset = 0) const -> size_t {
+        while(size_t n = check(base + offset, length - offset)) {
+            const auto* head = reinterpret_cast<const FrameHeader*>(base + offset);
+            const auto* block = reinterpret_cast<const StoredBlock*>(base + offset + sizeof(FrameHeader));
+            std::string_view extension(reinterpret_cast<const char*>(block + 1),
+                                       head->length - sizeof(StoredBlock));
+            if(!fn(*block, extension, offset)) return offset + n;
+            offset += n;
+        }
+        return offset;
+    }
+};
+
+// Streams every stored block, zero-copy, segment by segment
+template <typename Visitor>
+static qfunc for_each(const QubistString& directory, Visitor fn) -> QubistInt {
+    QubistInt visited = 0;
+    bool keep_going = true;
+    for(int i = 0, n = segment_count(directory); i < n && keep_going; i++) {
+        MappedSegment segment(segment_path(directory, i));
+        segment.walk([&](const StoredBlock& block, std::string_view extension, size_t) {
+            visited++;
+            keep_going = fn(block, extension);
+            return keep_going;
+        });
+    }
+    return visited;
+}
+
+// Streams the blocks stored at or after location `from`;
+// fn(block, extension, location) returns false to stop
+template <typename Visitor>
+static qfunc for_each_from(const QubistString& directory, uint64_t from, Visitor fn) -> void {
+    bool keep_going = true;
+    for(int i = location_segment(from), n = segment_count(directory); i < n && keep_going; i++) {
+        MappedSegment segment(segment_path(directory, i));
+        size_t start = i == location_segment(from) ? size_t(location_offset(from)) : 0;
+        if(start > segment.size()) continue;
+        segment.walk([&](const StoredBlock& block, std::string_view extension, size_t offset) {
+            keep_going = fn(block, extension, location(uint64_t(i), offset));
+            return keep_going;
+        }, start);
+    }
+}
+
+// One record by location, read with pread rather than mapping the segment
+static qfunc read_at(const QubistString& directory, uint64_t at, StoredBlock& block, std::string& extension) -> bool {
+    int fd = ::open(segment_path(directory, location_segment(at)).c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    auto offset = off_t(location_offset(at));
+    FrameHeader head;
+    std::string frame;
+    bool ok = ::pread(fd, &head, sizeof(head), offset) == ssize_t(sizeof(head)) && head.magic == magic;
+    if(ok) {
+        frame.resize(frame_size(head.length));
+        ok = ::pread(fd, frame.data(), frame.size(), offset) == ssize_t(frame.size()) &&
+             check(reinterpret_cast<const uint8_t*>(frame.data()), frame.size()) == frame.size();
+    }
+    ::close(fd);
+    if(!ok) return false;
+    std::memcpy(&block, frame.data() + sizeof(FrameHeader), sizeof(StoredBlock));
+    extension.assign(frame.data() + sizeof(FrameHeader) + sizeof(StoredBlock), head.length - sizeof(StoredBlock));
+    return true;
+}
+
+// Finds the last stored block via the trailing length of the final record. A
+// torn tail falls back to a scan of that segment and is truncated away.
+static qfunc recover_tip(const QubistString& directory, StoredBlock& tip) -> bool {
+    for(int index = segment_count(directory) - 1; index >= 0; index--) {
+        QubistString path = segment_path(directory, index);
+        MappedSegment segment(path);
+        if(segment.size() == 0) continue;
+
+        const uint8_t* base = segment.data();
+        size_t end = segment.size();
+        uint32_t length = 0;
+        if(end >= sizeof(FrameHeader) + 4) std::memcpy(&length, base + end - 4, 4);
+        size_t total = frame_size(length);
+        if(total <= end && check(base + end - total, total) == total) {
+            std::memcpy(&tip, base + end - total + sizeof(FrameHeader), sizeof(StoredBlock));
+            return true;
+        }
+
+        size_t last = std::numeric_limits<size_t>::max();
+        size_t valid_end = segment.walk([&](const StoredBlock&, std::string_view, size_t offset) {
+            last = offset;
+            return true;
+        });
+        std::cout << "[!] Dropping torn record at end of " << path << std::endl;
+        std::filesystem::resize_file(path, valid_end);
+        if(last != std::numeric_limits<size_t>::max()) {
+            std::memcpy(&tip, base + last + sizeof(FrameHeader), sizeof(StoredBlock));
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace BlockStore
+
+// ==================== CHAIN WRITER ====================
+// Blocks are handed to a dedicated writer thread through a lock-free MPSC
+// queue. The writer keeps the chain file (or block store segment) open,
+// appends whatever has queued up in one write(), and syncs according to the
+// durability policy, so mining threads never wait on the disk. Producers
+// claim their location with a compare-and-swap, never a lock; two that race
+// may enqueue out of order, so the writer puts records back in location order.
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+    std::atomic<Node*> head;    // producers link new nodes here
+    Node* tail;                 // consumer-owned stub
+
+public:
+    qfunc MpscQueue() {
+        tail = new Node();
+        head.store(tail);
+    }
+
+    qfunc ~MpscQueue() {
+        T discard;
+        while(pop(discard)) {}
+        delete tail;
+    }
+
+    qfunc push(T value) -> void {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Single consumer only
+    qfunc pop(T& out) -> bool {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if(!next) return false;
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+};
+
+// none: the OS decides; interval: one fdatasync per group of records;
+// per_block: every record written and fsynced on its own, no grouping
+enum class Durability { none, interval, per_block };
+
+struct DurabilityPolicy {
+    Durability mode = Durability::interval;
+    QubistInt every_blocks = 64;     // interval: fdatasync after this many blocks...
+    QubistInt every_ms = 100;        // ...or once this much time has passed
+
+    static qfunc parse(const QubistString& mode, QubistInt blocks, QubistInt ms) -> DurabilityPolicy {
+        DurabilityPolicy policy{Durability::interval, std::max<QubistInt>(1, blocks), std::max<QubistInt>(1, ms)};
+        if(mode == "none") policy.mode = Durability::none;
+        else if(mode == "block") policy.mode = Durability::per_block;
+        else if(mode != "interval") throw std::invalid_argument("unknown durability policy: " + mode);
+        return policy;
+    }
+};
+
+// Append-only output that is either one file (segment_limit 0) or a directory
+// of BlockStore segments rotated before a record would cross the limit
+class SegmentedFile {
+private:
+    QubistString location;
+    uint64_t segment_limit = 0;
+    int segment = 0;
+    int fd = -1;
+    uint64_t size = 0;
+
+    qfunc open_current() -> void {
+        QubistString path = segment_limit ? BlockStore::segment_path(location, segment) : location;
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0) throw std::runtime_error("cannot open chain file " + path + ": " + std::strerror(errno));
+        struct stat st;
+        ::fstat(fd, &st);
+        size = uint64_t(st.st_size);
+    }
+
+    qfunc write_all(const QubistString& data) -> void {
+        size_t offset = 0;
+        while(offset < data.size()) {
+            ssize_t n = ::write(fd, data.data() + offset, data.size() - offset);
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                throw std::runtime_error(QubistString("chain write failed: ") + std::strerror(errno));
+            }
+            offset += size_t(n);
+        }
+        size += data.size();
+    }
+
+public:
+    qfunc SegmentedFile(QubistString path, uint64_t limit) : location(std::move(path)), segment_limit(limit) {
+        if(segment_limit) {
+            std::filesystem::create_directories(location);
+            segment = std::max(0, BlockStore::segment_count(location) - 1);
+        }
+        open_current();
+    }
+
+    qfunc ~SegmentedFile() {
+        if(fd >= 0) ::close(fd);
+    }
+
+    // Whole records only: a record never straddles two segments
+    qfunc write(const std::vector<QubistString>& records) -> void {
+        QubistString buffer;
+        for(const auto& record : records) {
+            if(BlockStore::rolls_over(size + buffer.size(), record.size(), segment_limit)) {
+                write_all(buffer);
+                buffer.clear();
+                sync(false);              // a finished segment is always made durable
+                ::close(fd);
+                segment++;
+                open_current();
+            }
+            buffer += record;
+        }
+        write_all(buffer);
+    }
+
+    qfunc sync(bool metadata) -> void {
+        if((metadata ? ::fsync(fd) : ::fdatasync(fd)) != 0) {
+            throw std::runtime_error(QubistString("chain sync failed: ") + std::strerror(errno));
+        }
+    }
+
+    // Location the next record will get if nothing is queued ahead of it
+    qfunc end() const -> uint64_t {
+        return BlockStore::location(uint64_t(segment), size);
+    }
+};
+
+class ChainWriter {
+private:
+    SegmentedFile file;
+    DurabilityPolicy policy;
+    // A record and the location its producer found free, i.e. where the
+    // record before it ends; its own location follows from that
+    struct Queued {
+        uint64_t follows = 0;
+        QubistString record;
+    };
+    MpscQueue<Queued> queue;
+    uint64_t segment_limit;
+    std::atomic<uint64_t> next_location{0};   // producer-side mirror of where records land
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> signal{0};      // bumped on every append and on shutdown
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    mutable std::mutex error_mutex;
+    QubistString error;                    // why the file stopped taking records
+
+    // Flush accounting, updated by the writer thread only
+    std::atomic<uint64_t> flushes{0};
+    std::atomic<uint64_t> flush_ns_total{0};
+    std::atomic<uint64_t> flush_ns_last{0};
+    std::atomic<uint64_t> flush_ns_max{0};
+
+    std::thread worker;
+
+    // A failed write or sync stops the writer: that batch is never counted
+    // as written, and later appends throw
+    qfunc run() -> void {
+        Placement::pin_io();
+        try {
+            write_loop();
+        } catch(const std::exception& e) {
+            std::cout << "❌ Chain writer stopped: " << e.what() << std::endl;
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = e.what();
+            failed.store(true, std::memory_order_release);
+        }
+    }
+
+    qfunc check() const -> void {
+        if(!failed.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(error_mutex);
+        throw std::runtime_error("chain writer failed: " + error);
+    }
+
+    // Location of a `size`-byte record placed after `follows`
+    qfunc place(uint64_t follows, uint64_t size) const -> uint64_t {
+        if(!BlockStore::rolls_over(BlockStore::location_offset(follows), size, segment_limit)) return follows;
+        return BlockStore::location(uint64_t(BlockStore::location_segment(follows)) + 1, 0);
+    }
+
+    qfunc write_loop() -> void {
+        std::vector<QubistString> batch;
+        std::unordered_map<uint64_t, QubistString> early;     // queued ahead of a record still being pushed
+        uint64_t cursor = file.end();                          // where the next record in order starts
+        QubistInt unsynced = 0;
+        // The fsync timer stays on the real clock: it decides when bytes are
+        // durable, never which bytes are written
+        auto last_sync = std::chrono::steady_clock::now();
+
+        while(true) {
+            uint64_t seen = signal.load(std::memory_order_acquire);
+
+            // Group commit: everything queued so far goes out together, in
+            // location order. Seeded runs flush one record at a time so flush
+            // counts are reproducible.
+            batch.clear();
+            Queued queued;
+            while(queue.pop(queued)) early.emplace(queued.follows, std::move(queued.record));
+            for(auto next = early.find(cursor); next != early.end(); next = early.find(cursor)) {
+                cursor = place(cursor, next->second.size()) + next->second.size();
+                batch.push_back(std::move(next->second));
+                early.erase(next);
+                if(Simulation::enabled()) break;
+            }
+            QubistInt records = QubistInt(batch.size());
+
+            auto now = std::chrono::steady_clock::now();
+            if(records > 0 && policy.mode == Durability::per_block) {
+                for(auto& record : batch) {
+                    auto flush_start = Simulation::now();
+                    file.write({std::move(record)});
+                    file.sync(true);
+                    record_flush(Simulation::now() - flush_start);
+                    written.fetch_add(1, std::memory_order_release);
+                }
+                continue;
+            }
+            if(records > 0) {
+                auto flush_start = Simulation::now();
+                file.write(batch);
+                unsynced += records;
+
+                bool sync = policy.mode == Durability::interval &&
+                            (unsynced >= policy.every_blocks ||
+                             now - last_sync >= std::chrono::milliseconds(policy.every_ms));
+                if(sync) {
+                    file.sync(false);
+                    unsynced = 0;
+                    last_sync = std::chrono::steady_clock::now();
+                }
+                record_flush(Simulation::now() - flush_start);
+                written.fetch_add(records, std::memory_order_release);
+                continue;
+            }
+
+            if(stopping.load(std::memory_order_acquire)) break;
+
+            if(policy.mode == Durability::interval && unsynced > 0) {
+                // Data is waiting on the timer: nap in short slices until it is due
+                auto due = last_sync + std::chrono::milliseconds(policy.every_ms);
+                if(now >= due) {
+                    file.sync(false);
+                    unsynced = 0;
+                    last_sync = std::chrono::steady_clock::now();
+                } else {
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        due - now, std::chrono::milliseconds(1)));
+                }
+                continue;
+            }
+
+            signal.wait(seen, std::memory_order_acquire);
+        }
+
+        if(unsynced > 0 && policy.mode != Durability::none) file.sync(false);
+    }
+
+    qfunc record_flush(std::chrono::steady_clock::duration elapsed) -> void {
+        uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        flushes.fetch_add(1, std::memory_order_relaxed);
+        flush_ns_total.fetch_add(ns, std::memory_order_relaxed);
+        flush_ns_last.store(ns, std::memory_order_relaxed);
+        if(ns > flush_ns_max.load(std::memory_order_relaxed)) flush_ns_max.store(ns, std::memory_order_relaxed);
+    }
+
+public:
+    // segment_limit 0 appends to the single file `path`; otherwise `path` is a
+    // BlockStore directory
+    qfunc ChainWriter(qpath path, uint64_t segment_limit, DurabilityPolicy durability)
+        : file(path, segment_limit), policy(durability), segment_limit(segment_limit) {
+        next_location.store(file.end(), std::memory_order_release);
+        worker = std::thread([this]() { run(); });
+    }
+
+    qfunc ~ChainWriter() {
+        stopping.store(true, std::memory_order_release);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+        worker.join();
+    }
+
+    // Never touches the disk or takes a lock; the record is written by the
+    // writer thread. Returns the BlockStore location it will be written at.
+    qfunc append(QubistString record) -> uint64_t {
+        check();
+        uint64_t follows = next_location.load(std::memory_order_acquire);
+        uint64_t at = place(follows, record.size());
+        while(!next_location.compare_exchange_weak(follows, at + record.size(), std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+            at = place(follows, record.size());
+        }
+        queue.push(Queued{follows, std::move(record)});
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+        return at;
+    }
+
+    // Where the next record goes once everything queued is written
+    qfunc end() const -> uint64_t {
+        return next_location.load(std::memory_order_acquire);
+    }
+
+    // Waits until every queued record has reached the file (not necessarily
+    // the disk); throws if the writer stopped first
+    qfunc drain() const -> void {
+        while(queue_depth() > 0 && !failed.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        check();
+    }
+
+    qfunc queue_depth() const -> QubistInt {
+        uint64_t out = written.load(std::memory_order_acquire);
+        uint64_t in = pushed.load(std::memory_order_acquire);
+        return in > out ? QubistInt(in - out) : 0;
+    }
+
+    qfunc flush_count() const -> uint64_t { return flushes.load(std::memory_order_relaxed); }
+    qfunc flush_ns() const -> uint64_t { return flush_ns_total.load(std::memory_order_relaxed); }
+
+    qfunc stats() const -> QubistDict {
+        uint64_t count = flushes.load(std::memory_order_relaxed);
+        return QubistDict{
+            {"queue_depth", queue_depth()},
+            {"blocks_written", QubistInt(written.load(std::memory_order_relaxed))},
+            {"flushes", QubistInt(count)},
+            {"flush_ms_last", flush_ns_last.load(std::memory_order_relaxed) / 1e6},
+            {"flush_ms_max", flush_ns_max.load(std::memory_order_relaxed) / 1e6},
+            {"flush_ms_avg", count ? flush_ns_total.load(std::memory_order_relaxed) / 1e6 / count : 0.0}
+        };
+    }
+};
+
+// ==================== BLOCK INDEX ====================
+// Every stored block, main chain or not, as a 72-byte entry in one vector,
+// found by hash through an open-addressed table of entry numbers (linear
+// probing, at most half full). Parents are entry numbers, so walking a branch
+// never hashes. The active tip is the one the ledger and the miner follow; it
+// moves to the entry with the most cumulative work.
+class BlockIndex {
+public:
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    struct Entry {
+        Hash256 hash;
+        ChainWork work;           // cumulative, genesis included
+        uint64_t location = 0;    // BlockStore location of the record
+        uint32_t parent = none;
+        uint32_t height = 0;
+        uint32_t bits = 0;
+        uint32_t time = 0;        // header timestamp, for retargeting
+    };
+    static_assert(sizeof(Entry) == 72, "index entry layout changed");
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;
+        uint64_t store_end;       // store location the index is complete up to
+        uint32_t active;
+        uint32_t reserved;
+    };
+    static constexpr uint32_t file_magic = 0x58444951;      // "QIDX"
+    static constexpr uint32_t file_version = 2;             // 2: entries carry the block time
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> slots;                // entry numbers; none marks a free slot
+    uint32_t active_tip = none;
+    uint32_t best_tip = none;
+
+    qfunc slot_of(const Hash256& hash) const -> size_t {
+        size_t mask = slots.size() - 1;
+        size_t slot = Hash256::Hasher{}(hash) & mask;
+        while(slots[slot] != none && entries[slots[slot]].hash != hash) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    qfunc rehash(size_t capacity) -> void {
+        slots.assign(capacity, none);
+        for(uint32_t i = 0; i < entries.size(); i++) slots[slot_of(entries[i].hash)] = i;
+    }
+
+public:
+    qfunc find(const Hash256& hash) const -> uint32_t {
+        return slots.empty() ? none : slots[slot_of(hash)];
+    }
+
+    // Adds a block under `parent` (none for a root); the entry number
+    qfunc add(const Hash256& hash, uint32_t parent, uint32_t height, uint32_t bits, uint32_t time,
+              uint64_t location) -> uint32_t {
+        if(2 * (entries.size() + 1) > slots.size()) rehash(std::max<size_t>(1024, 2 * slots.size()));
+
+        Entry entry;
+        entry.hash = hash;
+        entry.parent = parent;
+        entry.height = height;
+        entry.bits = bits;
+        entry.time = time;
+        entry.location = location;
+        entry.work = QuantumTarget::from_compact(bits).work();
+        if(parent != none) entry.work = entry.work + entries[parent].work;
+
+        auto number = uint32_t(entries.size());
+        entries.push_back(entry);
+        slots[slot_of(hash)] = number;
+        if(best_tip == none || entries[best_tip].work < entry.work) best_tip = number;
+        return number;
+    }
+
+    qfunc operator[](uint32_t number) const -> const Entry& { return entries[number]; }
+    qfunc size() const -> size_t { return entries.size(); }
+    qfunc best() const -> uint32_t { return best_tip; }
+    qfunc active() const -> uint32_t { return active_tip; }
+    qfunc set_active(uint32_t number) -> void { active_tip = number; }
+
+    // Last entry shared by the branches ending at `a` and `b`, or none
+    qfunc fork_point(uint32_t a, uint32_t b) const -> uint32_t {
+        while(a != b && a != none && b != none) {
+            if(entries[a].height >= entries[b].height) a = entries[a].parent;
+            else b = entries[b].parent;
+        }
+        return a == b ? a : none;
+    }
+
+    qfunc memory_bytes() const -> size_t {
+        return entries.capacity() * sizeof(Entry) + slots.capacity() * sizeof(uint32_t);
+    }
+
+    // Temp file and rename, so a crash leaves the previous index intact
+    qfunc save(const QubistString& path, uint64_t store_end) const -> void {
+        QubistString tmp_path = path + ".tmp";
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        FileHeader head{file_magic, file_version, entries.size(), store_end, active_tip, 0};
+        out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        out.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size() * sizeof(Entry)));
+        out.close();
+        if(!out) throw std::runtime_error("cannot write block index " + tmp_path);
+        std::filesystem::rename(tmp_path, path);
+    }
+
+    // The store location the saved index covers, or nullopt if there is none
+    qfunc load(const QubistString& path) -> std::optional<uint64_t> {
+        std::ifstream in(path, std::ios::binary);
+        FileHeader head;
+        if(!in.read(reinterpret_cast<char*>(&head), sizeof(head)) || head.magic != file_magic || head.version != file_version) {
+            return std::nullopt;
+        }
+        std::vector<Entry> loaded(head.count);
+        if(!in.read(reinterpret_cast<char*>(loaded.data()), std::streamsize(loaded.size() * sizeof(Entry)))) {
+            return std::nullopt;
+        }
+
+        entries = std::move(loaded);
+        size_t capacity = 1024;
+        while(capacity < 2 * entries.size()) capacity *= 2;
+        rehash(capacity);
+        best_tip = none;
+        for(uint32_t i = 0; i < entries.size(); i++) {
+            if(best_tip == none || entries[best_tip].work < entries[i].work) best_tip = i;
+        }
+        active_tip = head.active < entries.size() ? head.active : best_tip;
+        return head.store_end;
+    }
+
+    qfunc clear() -> void {
+        entries.clear();
+        slots.clear();
+        active_tip = best_tip = none;
+    }
+};
+
+// ==================== STATE SNAPSHOTS ====================
+// Every agent balance as of one block on the chain, so the ledger can be
+// rebuilt by replaying only the blocks after it. Files are named by height and
+// carry a SHA-256 over a canonical encoding of their contents, checked on load.
+// The genesis snapshot (height 0, zero tip) holds the balances from before the
+// first block; it has its own file and is never rotated out.
+struct StateSnapshot {
+    uint64_t height = 0;
+    Hash256 tip;
+    std::vector<std::pair<QubistString, QubistFloat>> balances;     // sorted by agent id
+
+    static constexpr const char* directory = "data/snapshots";
+    static constexpr const char* genesis_name = "genesis.json";
+    static constexpr size_t keep = 3;
+
+    static qfunc genesis_path() -> QubistString {
+        return (std::filesystem::path(directory) / genesis_name).string();
+    }
+
+    // height | tip | (id length, id, balance)*, little-endian
+    qfunc content_hash() const -> Hash256 {
+        std::string canonical;
+        canonical.append(reinterpret_cast<const char*>(&height), 8);
+        canonical.append(reinterpret_cast<const char*>(tip.data()), 32);
+        for(const auto& [id, balance] : balances) {
+            auto length = uint32_t(id.size());
+            canonical.append(reinterpret_cast<const char*>(&length), 4);
+            canonical.append(id);
+            canonical.append(reinterpret_cast<const char*>(&balance), 8);
+        }
+        return Hash256::of(canonical.data(), canonical.size());
+    }
+
+    // Newest first
+    static qfunc available() -> std::vector<QubistString> {
+        std::vector<QubistString> paths;
+        if(!std::filesystem::exists(directory)) return paths;
+        for(const auto& file : std::filesystem::directory_iterator(directory)) {
+            QubistString name = file.path().filename().string();
+            if(name.rfind("snapshot_", 0) == 0 && file.path().extension() == ".json") paths.push_back(file.path().string());
+        }
+        std::sort(paths.rbegin(), paths.rend());      // zero-padded heights sort as text
+        return paths;
+    }
+
+    // Temp file and rename; keeps the newest `keep` snapshots
+    qfunc save() const -> QubistString {
+        std::filesystem::create_directories(directory);
+        char name[48];
+        std::snprintf(name, sizeof(name), "snapshot_%012llu.json", static_cast<unsigned long long>(height));
+        QubistString path = tip == Hash256{} ? genesis_path() : (std::filesystem::path(directory) / name).string();
+
+        QubistList entries;
+        for(const auto& [id, balance] : balances) entries.push_back(QubistList{id, balance});
+        QubistDict document = {
+            {"height", QubistInt(height)},
+            {"tip", tip.to_hex()},
+            {"content_hash", content_hash().to_hex()},
+            {"balances", entries}
+        };
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            out << json::dump(document) << '\n';
+            if(!out) throw std::runtime_error("cannot write snapshot " + path);
+        }
+        std::filesystem::rename(path + ".tmp", path);
+
+        std::vector<QubistString> paths = available();
+        for(size_t i = keep; i < paths.size(); i++) std::filesystem::remove(paths[i]);
+        return path;
+    }
+
+    static qfunc load(const QubistString& path) -> StateSnapshot {
+        std::ifstream in(path);
+        QubistDict document = json::parse(in);
+        StateSnapshot snapshot;
+        snapshot.height = uint64_t(QubistInt(document["height"]));
+        snapshot.tip = Hash256::from_hex(QubistString(document["tip"]));
+        for(QubistList entry : QubistList(document["balances"])) {
+            snapshot.balances.emplace_back(QubistString(entry[0]), QubistFloat(entry[1]));
+        }
+        if(snapshot.content_hash() != Hash256::from_hex(QubistString(document["content_hash"]))) {
+            throw std::runtime_error("snapshot content hash mismatch: " + path);
+        }
+        return snapshot;
+    }
+};
+
+// ==================== QUBIST CONFIG ====================
+// Miner settings from the "blockchain" block of Qubist_config.json; missing
+// keys keep their defaults.
+struct BlockchainSettings {
+    QubistString file = "mirror_chain.jsonl";
+    QubistString target_hash = "0000";
+    QubistFloat reward = 50.0;
+    QubistFloat target_block_time = 10.0;
+    QubistInt retarget_window = 16;
+    QubistFloat max_retarget_factor = 4.0;
+    QubistInt max_block_bytes = 65536;        // transaction payload per block
+    QubistString hash_function = "sha256";    // HashPolicy name; fixed for the life of a chain
+    QubistInt snapshot_interval = 1000;       // blocks between state snapshots; 0 disables
+    QubistString payout_agent = "bot_satoshi_mirror";     // paid every block's reward; fixed for the life of a chain
+
+    static qfunc load(qpath path = "Qubist_config.json") -> BlockchainSettings {
+        BlockchainSettings settings;
+        if(!std::filesystem::exists(path)) return settings;
+
+        std::ifstream f(path);
+        QubistDict root = json::parse(f);
+        if(!root.count("qubist_config")) return settings;
+        QubistDict qubist = root["qubist_config"];
+        if(!qubist.count("blockchain")) return settings;
+        QubistDict chain = qubist["blockchain"];
+
+        if(chain.count("file")) settings.file = chain["file"];
+        if(chain.count("target_hash")) settings.target_hash = chain["target_hash"];
+        if(chain.count("reward")) settings.reward = chain["reward"];
+        if(chain.count("target_block_time")) settings.target_block_time = chain["target_block_time"];
+        if(chain.count("retarget_window")) settings.retarget_window = chain["retarget_window"];
+        if(chain.count("max_retarget_factor")) settings.max_retarget_factor = chain["max_retarget_factor"];
+        if(chain.count("max_block_bytes")) settings.max_block_bytes = chain["max_block_bytes"];
+        if(chain.count("hash_function")) settings.hash_function = chain["hash_function"];
+        if(chain.count("snapshot_interval")) settings.snapshot_interval = chain["snapshot_interval"];
+        if(chain.count("payout_agent")) settings.payout_agent = chain["payout_agent"];
+        return settings;
+    }
+
+    // Initial target: one leading zero hex digit per '0' in target_hash
+    qfunc initial_target() const -> QuantumTarget {
+        QubistInt zeros = QubistInt(target_hash.find_first_not_of('0'));
+        if(zeros < 0) zeros = QubistInt(target_hash.size());
+        return QuantumTarget::from_hex_zeros(std::max<QubistInt>(1, zeros));
+    }
+};
+
+// ==================== BLOCK PIPELINE ====================
+// continuous_mining overlaps three stages: the template for block N+1 is
+// assembled while N is being hashed, and rendering, chain append and console
+// output for a solved block run on the publisher thread. The hashing threads
+// only ever hash.
+using MinerKey = std::unique_ptr<EC_KEY, decltype(&EC_KEY_free)>;
+
+// secp256k1 keys are generated ahead of use by a SCHED_IDLE thread, which
+// tops the pool up whenever it falls below half full. take() only generates
+// inline when the pool has run dry. Seeded runs have no refill thread: each
+// key is derived inline from the seed in take() order.
+class KeypairPool {
+private:
+    size_t capacity;
+    std::deque<MinerKey> keys;
+    std::mutex mutex;
+    std::condition_variable refill;
+    bool stopping = false;
+    std::atomic<uint64_t> misses{0};
+    std::thread worker;
+
+    qfunc run() -> void {
+        sched_param idle{};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &idle);
+        Placement::pin_io();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!stopping) {
+            if(keys.size() >= capacity) {
+                refill.wait(lock, [this]() { return stopping || keys.size() < capacity / 2; });
+                continue;
+            }
+            lock.unlock();
+            MinerKey key = generate();
+            lock.lock();
+            keys.push_back(std::move(key));
+        }
+    }
+
+public:
+    qfunc KeypairPool(size_t size = 64) : capacity(std::max<size_t>(2, size)) {
+        if(!Simulation::enabled()) worker = std::thread([this]() { run(); });
+    }
+
+    qfunc ~KeypairPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        refill.notify_one();
+        if(worker.joinable()) worker.join();
+    }
+
+    static qfunc generate() -> MinerKey {
+        MinerKey key(EC_KEY_new_by_curve_name(NID_secp256k1), EC_KEY_free);
+        if(!key) throw std::runtime_error("secp256k1 keygen failed");
+        bool generated = Simulation::enabled() ? derive_key(key.get()) : EC_KEY_generate_key(key.get()) == 1;
+        if(!generated) throw std::runtime_error("secp256k1 keygen failed");
+        EC_KEY_set_conv_form(key.get(), POINT_CONVERSION_COMPRESSED);
+        return key;
+    }
+
+    // The n-th secret of the seeded "keypair" stream, reduced into [1, order)
+    static qfunc derive_key(EC_KEY* key) -> bool {
+        static std::atomic<uint64_t> drawn{0};
+        Hash256 secret = Simulation::derive("keypair", drawn.fetch_add(1));
+        const EC_GROUP* group = EC_KEY_get0_group(key);
+        std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)> ctx(BN_CTX_new(), BN_CTX_free);
+        std::unique_ptr<BIGNUM, decltype(&BN_free)> priv(BN_bin2bn(secret.data(), 32, nullptr), BN_free);
+        std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)> pub(EC_POINT_new(group), EC_POINT_free);
+        if(!ctx || !priv || !pub || BN_nnmod(priv.get(), priv.get(), EC_GROUP_get0_order(group), ctx.get()) != 1) return false;
+        if(BN_is_zero(priv.get())) BN_one(priv.get());
+        return EC_POINT_mul(group, pub.get(), priv.get(), nullptr, nullptr, ctx.get()) == 1 &&
+               EC_KEY_set_private_key(key, priv.get()) == 1 && EC_KEY_set_public_key(key, pub.get()) == 1;
+    }
+
+    qfunc take() -> MinerKey {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(keys.empty()) {
+            lock.unlock();
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return generate();
+        }
+        MinerKey key = std::move(keys.front());
+        keys.pop_front();
+        bool low = keys.size() < capacity / 2;
+        lock.unlock();
+        if(low) refill.notify_one();
+        return key;
+    }
+
+    qfunc miss_count() const -> uint64_t { return misses.load(std::memory_order_relaxed); }
+};
+
+struct BlockTemplate {
+    QuantumBlockHeader header;        // version, merkle root; parent/time/bits set at link time
+    QubistInt height = 0;
+    MinerKey key{nullptr, EC_KEY_free};
+    std::vector<QuantumTransaction> transactions;
+    QubistFloat fees = 0.0;
+};
+
+class BlockPublisher {
+private:
+    std::function<void(const SealedBlock&)> sink;
+    MpscQueue<SealedBlock> queue;
+    std::atomic<uint64_t> signal{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    QubistString error;           // first failure; later blocks are dropped
+    std::thread worker;
+
+    qfunc run() -> void {
+        Placement::pin_io();
+        while(true) {
+            uint64_t seen = signal.load(std::memory_order_acquire);
+            SealedBlock block;
+            bool drained = false;
+            while(queue.pop(block)) {
+                drained = true;
+                if(failed.load(std::memory_order_relaxed)) {
+                    std::cout << "❌ Block #" << block.block.height << " dropped: publisher stopped" << std::endl;
+                    continue;
+                }
+                try {
+                    sink(block);
+                } catch(const std::exception& e) {
+                    std::cout << "❌ Block #" << block.block.height << " not published: " << e.what() << std::endl;
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    error = e.what();
+                    failed.store(true, std::memory_order_release);
+                }
+            }
+            if(drained) continue;
+            if(stopping.load(std::memory_order_acquire)) break;
+            signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+public:
+    qfunc BlockPublisher(std::function<void(const SealedBlock&)> fn) : sink(std::move(fn)) {
+        worker = std::thread([this]() { run(); });
+    }
+
+    // Drains every queued block before returning
+    qfunc ~BlockPublisher() {
+        stopping.store(true, std::memory_order_release);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+        worker.join();
+    }
+
+    // Throws once a block has failed to publish, so the miner stops
+    qfunc publish(const SealedBlock& block) -> void {
+        if(failed.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            throw std::runtime_error("block publishing failed: " + error);
+        }
+        queue.push(block);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+};
+
+// ==================== MIRROR BLOCKCHAIN MINER ====================
+class QuantumMiner {
+private:
+    QubistInt current_height = 0;
+    QubistString chain_file = "mirror_chain.jsonl";
+    QubistFloat block_reward = 50.0;
+    QubistString payout_agent = "bot_satoshi_mirror";      // ledger agent credited with each block's reward
+    // One thread keeps per-thread hash counts reproducible in seeded runs
+    unsigned mining_threads = Simulation::enabled() ? 1 : Placement::hashing_threads();
+    QubistString hash_path = "midstate";   // "midstate" | "full"
+    HashKernels::Kernel hash_kernel = HashKernels::best();
+   
+    // Chain hash and target test, bound once to pre-instantiated code
+    using SearchFn = QubistInt (QuantumMiner::*)(const QuantumBlockHeader&, const QuantumTarget&);
+    using HashFn = void (*)(const QuantumBlockHeader&, uint8_t*);
+    QubistString chain_hash = HashPolicy::Sha256Single::name;
+    QubistString target_check = TargetCheck::HeadWord::name;
+    SearchFn search_fn = &QuantumMiner::search_with<HashPolicy::Sha256Single, TargetCheck::HeadWord>;
+    HashFn hash_fn = &HashPolicy::Sha256Single::hash;
+   
+    QuantumTarget block_target = QuantumTarget::from_hex_zeros(4);
+    std::optional<QuantumTarget> pending_target;    // set before the chain was resumed
+    DifficultyRetarget retarget;
+    QubistBool retargeting = true;
+    uint32_t block_version = 1;
+    Hash256 tip_hash;     // parent digest for the next block
+    uint32_t tip_time = 0;     // its timestamp; the next block's may not be earlier
+    // Guards the tip fields, block_target and retarget: in continuous mining
+    // the BlockPublisher thread moves them (reorg, lost race) while the
+    // mining thread links templates to them
+    mutable std::mutex tip_mutex;
+    BlockIndex index;     // every stored block; its active tip is what the ledger has booked
+   
+    QubistString chain_store = "jsonl";    // "jsonl" | "binary"
+    QubistString block_dir = "data/blocks";
+    DurabilityPolicy durability;
+    std::unique_ptr<ChainWriter> writer;   // opened on first append
+    std::unique_ptr<MiningTelemetry> telemetry;
+    std::unique_ptr<KeypairPool> key_pool;     // started with the chain writer
+    NonceSearch::Throttle throttle;            // turned by an EnergyGovernor, when one is attached
+    std::function<void()> block_hook;          // seeded runs: the governor's per-block step
+   
+    Mempool mempool;
+    size_t max_block_bytes = 65536;
+    QuantumLedger* ledger = nullptr;           // balances for transfers; booked on append
+    QubistInt snapshot_interval = 1000;
+   
+    static constexpr QubistInt nonce_space = QubistInt(1) << 32;
+    static constexpr uint32_t max_time_drift = 2 * 60 * 60;    // seconds an imported block may run ahead
+   
+    qfunc generate_quantum_hash(const QuantumBlockHeader& header) const -> Hash256 {
+        // Quantum-inspired hash function (chain_hash policy)
+        Hash256 digest;
+        hash_fn(header, digest.data());
+        return digest;
+    }
+
+    // The coinbase commits to height and reward (subsidy plus fees)
+    static qfunc commit_coinbase(QubistInt height, QubistFloat reward) -> Hash256 {
+        std::string coinbase = "coinbase:" + std::to_string(height) + ":" + std::to_string(reward);
+        return Hash256::of(coinbase.data(), coinbase.size());
+    }
+
+    // Everything about block `height` that does not depend on its parent;
+    // safe to run off the mining thread
+    qfunc prepare_template(QubistInt height) -> BlockTemplate {
+        auto started = Simulation::now();
+        BlockTemplate tmpl;
+        tmpl.height = height;
+        tmpl.header.version = block_version;
+       
+        tmpl.transactions = mempool.take_block(max_block_bytes);
+        for(const auto& tx : tmpl.transactions) tmpl.fees += tx.fee;
+        tmpl.header.merkle_root = merkle_root(commit_coinbase(height, block_reward + tmpl.fees), tmpl.transactions);
+       
+        // Quantum-secure keypair for the block, pre-generated off the mining path
+        tmpl.key = key_pool ? key_pool->take() : KeypairPool::generate();
+        if(telemetry) telemetry->add_phase(Telemetry::phase_template, Simulation::now() - started);
+        return tmpl;
+    }
+
+    // Links the template to the current tip and runs the nonce search
+    qfunc solve_template(BlockTemplate& tmpl, const QuantumTarget& target) -> SealedBlock {
+        QuantumBlockHeader& header = tmpl.header;
+        link_template(tmpl, target);
+       
+        // Mine block with quantum-resistant algorithm across every core
+        auto start = Simulation::now();
+       
+        QubistInt nonce = search_header(header, target);
+        QubistInt rolls = 0;
+        while(nonce == NonceSearch::not_found) {
+            // 32-bit nonce space exhausted: roll the timestamp and sweep again
+            header.time++;
+            rolls++;
+            nonce = search_header(header, target);
+        }
+        header.nonce = uint32_t(nonce);
+        Simulation::advance_hashes(rolls * nonce_space + nonce + 1);
+       
+        auto end = Simulation::now();
+        auto duration = std::chrono::duration<double>(end - start).count();
+        if(telemetry) {
+            telemetry->add_phase(Telemetry::phase_search, end - start);
+            telemetry->record_block(rolls * nonce_space + nonce + 1, duration);
+        }
+        return finish_block(tmpl, duration);
+    }
+
+    qfunc link_template(BlockTemplate& tmpl, const QuantumTarget& target) const -> void {
+        std::lock_guard<std::mutex> lock(tip_mutex);
+        tmpl.header.previous_hash = tip_hash;
+        tmpl.header.time = std::max(uint32_t(Simulation::unix_time()), tip_time);
+        tmpl.header.bits = target.bits();
+    }
+
+    // Makes a solved template the new tip, retargets for its child and signs it
+    qfunc finish_block(BlockTemplate& tmpl, QubistFloat duration) -> SealedBlock {
+        StoredBlock stored;
+        stored.header = tmpl.header;
+        stored.height = uint64_t(tmpl.height);
+        stored.hash = generate_quantum_hash(tmpl.header);
+        stored.mining_time = duration;
+        stored.reward = block_reward + tmpl.fees;
+       
+        {
+            std::lock_guard<std::mutex> lock(tip_mutex);
+            QuantumTarget mined_at = QuantumTarget::from_compact(tmpl.header.bits);
+            if(tmpl.header.previous_hash != Hash256{}) retarget.record(mined_at, retarget_seconds(tmpl.header.time, tip_time));
+            if(retargeting) block_target = retarget.next(mined_at);
+            current_height = tmpl.height;
+            tip_hash = stored.hash;
+            tip_time = tmpl.header.time;
+        }
+        return SealedBlock{stored, seal_block(tmpl.key.get(), stored), std::move(tmpl.transactions)};
+    }
+
+    // Seeded runs: the ECDSA nonce is SHA-256(secret | digest), so a seal
+    // depends only on the key and the block, as with RFC 6979
+    static qfunc sign_derived(EC_KEY* key, const Hash256& digest) -> ECDSA_SIG* {
+        const EC_GROUP* group = EC_KEY_get0_group(key);
+        const BIGNUM* order = EC_GROUP_get0_order(group);
+        uint8_t material[64];
+        BN_bn2binpad(EC_KEY_get0_private_key(key), material, 32);
+        std::memcpy(material + 32, digest.data(), 32);
+        Hash256 nonce = Hash256::of(material, sizeof(material));
+
+        std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)> ctx(BN_CTX_new(), BN_CTX_free);
+        std::unique_ptr<BIGNUM, decltype(&BN_free)> k(BN_bin2bn(nonce.data(), 32, nullptr), BN_free);
+        std::unique_ptr<BIGNUM, decltype(&BN_free)> x(BN_new(), BN_free);
+        std::unique_ptr<BIGNUM, decltype(&BN_free)> r(BN_new(), BN_free);
+        std::unique_ptr<BIGNUM, decltype(&BN_free)> kinv(BN_new(), BN_free);
+        std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)> point(EC_POINT_new(group), EC_POINT_free);
+        if(!ctx || !k || !x || !r || !kinv || !point || BN_nnmod(k.get(), k.get(), order, ctx.get()) != 1) return nullptr;
+        if(BN_is_zero(k.get())) BN_one(k.get());
+        if(EC_POINT_mul(group, point.get(), k.get(), nullptr, nullptr, ctx.get()) != 1 ||
+           EC_POINT_get_affine_coordinates(group, point.get(), x.get(), nullptr, ctx.get()) != 1 ||
+           BN_nnmod(r.get(), x.get(), order, ctx.get()) != 1 ||
+           !BN_mod_inverse(kinv.get(), k.get(), order, ctx.get())) return nullptr;
+        return ECDSA_do_sign_ex(digest.data(), 32, kinv.get(), r.get(), key);
+    }
+
+    // Signs the block hash with the template's key
+    static qfunc seal_block(EC_KEY* key, const StoredBlock& stored) -> BlockSeal {
+        BlockSeal seal;
+        std::unique_ptr<ECDSA_SIG, decltype(&ECDSA_SIG_free)> sig(
+            Simulation::enabled() ? sign_derived(key, stored.hash) : ECDSA_do_sign(stored.hash.data(), 32, key),
+            ECDSA_SIG_free);
+        if(!sig) throw std::runtime_error("block signing failed");
+        const BIGNUM* r = nullptr;
+        const BIGNUM* s = nullptr;
+        ECDSA_SIG_get0(sig.get(), &r, &s);
+        BN_bn2binpad(r, seal.signature, 32);
+        BN_bn2binpad(s, seal.signature + 32, 32);
+        EC_POINT_point2oct(EC_KEY_get0_group(key), EC_KEY_get0_public_key(key), POINT_CONVERSION_COMPRESSED,
+                           seal.public_key, sizeof(seal.public_key), nullptr);
+        return seal;
+    }
+
+    static qfunc verify_seal(const StoredBlock& stored, const BlockSeal& seal) -> bool {
+        MinerKey key(EC_KEY_new_by_curve_name(NID_secp256k1), EC_KEY_free);
+        const EC_GROUP* group = EC_KEY_get0_group(key.get());
+        std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)> point(EC_POINT_new(group), EC_POINT_free);
+        if(EC_POINT_oct2point(group, point.get(), seal.public_key, sizeof(seal.public_key), nullptr) != 1 ||
+           EC_KEY_set_public_key(key.get(), point.get()) != 1) return false;
+
+        std::unique_ptr<ECDSA_SIG, decltype(&ECDSA_SIG_free)> sig(ECDSA_SIG_new(), ECDSA_SIG_free);
+        BIGNUM* r = BN_bin2bn(seal.signature, 32, nullptr);
+        BIGNUM* s = BN_bin2bn(seal.signature + 32, 32, nullptr);
+        if(ECDSA_SIG_set0(sig.get(), r, s) != 1) {
+            BN_free(r);
+            BN_free(s);
+            return false;
+        }
+        return ECDSA_do_verify(stored.hash.data(), 32, sig.get(), key.get()) == 1;
+    }
+
+    // Everything about a block that can be checked without its neighbours;
+    // returns the reason it is invalid, or nullptr
+    qfunc check_block(const StoredBlock& stored, const BlockSeal* seal,
+                      const std::vector<QuantumTransaction>& transactions) const -> const char* {
+        Hash256 digest = generate_quantum_hash(stored.header);
+        if(digest != stored.hash) return "hash does not match header";
+        if(!QuantumTarget::from_compact(stored.header.bits).met_by(digest.data())) return "proof of work above target";
+
+        QubistFloat fees = 0.0;
+        for(const auto& tx : transactions) fees += tx.fee;
+        if(stored.reward != block_reward + fees) return "reward differs from blockchain.reward plus fees";
+
+        Hash256 root = merkle_root(commit_coinbase(QubistInt(stored.height), stored.reward), transactions);
+        if(root != stored.header.merkle_root) return "merkle root does not match coinbase and transactions";
+        if(seal && !verify_seal(stored, *seal)) return "bad block signature";
+        return nullptr;
+    }
+
+    // Rebuilds the binary header from a JSONL record
+    static qfunc parse_block(const QubistString& record, StoredBlock& stored, BlockSeal& seal,
+                             std::vector<QuantumTransaction>& transactions) -> bool {
+        QubistDict block = json::parse(record);
+        if(!block.count("bits") || !block.count("merkle_root")) {
+            throw std::runtime_error("record predates binary headers");
+        }
+        stored.height = uint64_t(QubistInt(block["height"]));
+        stored.hash = Hash256::from_hex(QubistString(block["hash"]));
+        stored.header.version = uint32_t(QubistInt(block["version"]));
+        stored.header.previous_hash = Hash256::from_hex(QubistString(block["previous_hash"]));
+        stored.header.merkle_root = Hash256::from_hex(QubistString(block["merkle_root"]));
+        stored.header.time = uint32_t(QubistInt(block["timestamp"]));
+        stored.header.bits = uint32_t(QubistInt(block["bits"]));
+        stored.header.nonce = uint32_t(QubistInt(block["nonce"]));
+        stored.mining_time = block["mining_time"];
+        stored.reward = block["reward"];
+
+        if(block.count("transactions")) {
+            for(QubistDict entry : QubistList(block["transactions"])) {
+                QuantumTransaction tx = transaction_from_json(entry);
+                if(tx.id != Hash256::from_hex(QubistString(entry["id"]))) {
+                    throw std::runtime_error("transaction id mismatch");
+                }
+                transactions.push_back(std::move(tx));
+            }
+        }
+
+        if(!block.count("signature")) return false;
+        parse_quantum_hash(block["public_key"], seal.public_key, sizeof(seal.public_key));
+        parse_quantum_hash(block["signature"], seal.signature, sizeof(seal.signature));
+        return true;
+    }
+
+    // Render, append and report a solved block
+    // A block mined here extends the tip finish_block already moved to it
+    // (moved back if it lost the race); one from elsewhere may extend the
+    // active tip, start a side branch, or make a side branch the heaviest
+    // and trigger a reorg.
+    qfunc publish(const SealedBlock& sealed, QubistBool mined_here = true) -> QubistDict {
+        auto started = Simulation::now();
+        const StoredBlock& stored = sealed.block;
+        QubistDict block = render_block(stored, &sealed.seal, &sealed.transactions);
+        if(index.find(stored.hash) != BlockIndex::none) return block;
+        std::string record = chain_store == "binary" ? BlockStore::frame(stored, sealed.extension())
+                                                     : json::dump(block) + "\n";
+        if(telemetry) {
+            telemetry->add_phase(Telemetry::phase_serialize, Simulation::now() - started);
+            telemetry->set_phase(Telemetry::phase_append, writer->flush_ns(), writer->flush_count());
+        }
+       
+        // Save to chain (queued; the writer thread does the disk I/O)
+        uint64_t location = writer->append(std::move(record));
+        uint32_t parent = index.find(stored.header.previous_hash);
+        uint32_t entry = index.add(stored.hash, parent, uint32_t(stored.height), stored.header.bits, stored.header.time,
+                                   location);
+        uint32_t active = index.active();
+       
+        char block_hash[Hash256::hex_size];
+        stored.hash.write_hex(block_hash);
+        if(active != BlockIndex::none && !(index[active].work < index[entry].work)) {
+            std::cout << "🪵 Side block #" << stored.height << " stored (" << std::string_view(block_hash, 16)
+                      << "...), tip #" << index[active].height << " has more work" << std::endl;
+            if(mined_here) {        // lost the race: still unconfirmed, and mining goes back to the tip
+                mempool.restore(sealed.transactions);
+                move_tip(active);
+            }
+            return block;
+        }
+        if(active != BlockIndex::none && parent != active) {
+            reorganize(entry);
+            return block;
+        }
+       
+        if(ledger && active == BlockIndex::none && !std::filesystem::exists(StateSnapshot::genesis_path())) {
+            StateSnapshot genesis;      // balances no block booked, for restore
+            genesis.balances = ledger->balances();
+            genesis.save();
+        }
+        index.set_active(entry);
+        if(!mined_here) move_tip(entry);
+        if(ledger) ledger->connect_block(stored.hash, sealed.transactions, payout_agent, stored.reward);
+        mempool.remove(sealed.transactions);
+        if(ledger && snapshot_interval > 0 && stored.height % uint64_t(snapshot_interval) == 0) take_snapshot();
+       
+        std::cout << (mined_here ? "⛏️  Quantum block #" : "📥 Block #") << stored.height
+                  << (mined_here ? " mined" : " received") << std::endl;
+        std::cout << "   Hash: " << std::string_view(block_hash, 32) << "..." << std::endl;
+        std::cout << "   Nonce: " << stored.header.nonce << " | Time: " << stored.mining_time << "s" << std::endl;
+        std::cout << "   Reward: " << stored.reward << " mirror BTC";
+        if(!sealed.transactions.empty()) std::cout << " | " << sealed.transactions.size() << " transactions";
+        std::cout << std::endl;
+        return block;
+    }
+
+    // Points mining at entry `number`, at the target its child must carry
+    qfunc move_tip(uint32_t number) -> void {
+        const BlockIndex::Entry& tip = index[number];
+        DifficultyRetarget window = retarget_at(number);
+        QuantumTarget current = QuantumTarget::from_compact(tip.bits);
+        std::lock_guard<std::mutex> lock(tip_mutex);
+        current_height = QubistInt(tip.height);
+        tip_hash = tip.hash;
+        tip_time = tip.time;
+        retarget = window;
+        block_target = retargeting ? retarget.next(current) : current;
+    }
+
+    // Seconds a block took, from its parent's timestamp; never negative
+    static qfunc retarget_seconds(uint32_t time, uint32_t parent_time) -> QubistFloat {
+        return time > parent_time ? QubistFloat(time - parent_time) : 0.0;
+    }
+
+    // Retarget window as of entry `tip`: its newest blocks that have a
+    // parent, each with the seconds since its parent's timestamp. Blocks
+    // mined here feed the live window the same samples in finish_block.
+    qfunc retarget_at(uint32_t tip) const -> DifficultyRetarget {
+        DifficultyRetarget window;
+        {
+            std::lock_guard<std::mutex> lock(tip_mutex);
+            window = retarget;
+        }
+        window.reset();
+        std::vector<uint32_t> blocks;
+        for(uint32_t e = tip; e != BlockIndex::none && index[e].parent != BlockIndex::none && blocks.size() < window.span();
+            e = index[e].parent) {
+            blocks.push_back(e);
+        }
+        for(auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            const BlockIndex::Entry& block = index[*it];
+            window.record(QuantumTarget::from_compact(block.bits), retarget_seconds(block.time, index[block.parent].time));
+        }
+        return window;
+    }
+
+    // Target a child of entry `parent` must carry
+    qfunc expected_target(uint32_t parent) const -> QuantumTarget {
+        QuantumTarget current = QuantumTarget::from_compact(index[parent].bits);
+        return retargeting ? retarget_at(parent).next(current) : current;
+    }
+
+    // Reads an indexed block back from the chain store
+    qfunc load_block(const BlockIndex::Entry& entry) -> SealedBlock {
+        SealedBlock sealed;
+        bool ok;
+        if(chain_store == "binary") {
+            std::string extension;
+            ok = BlockStore::read_at(block_dir, entry.location, sealed.block, extension) &&
+                 decode_transactions(extension, sealed.transactions);
+            BlockSeal::from_extension(extension, sealed.seal);
+        } else {
+            std::ifstream chain(chain_file, std::ios::binary);
+            chain.seekg(std::streamoff(BlockStore::location_offset(entry.location)));
+            std::string record;
+            ok = bool(std::getline(chain, record));
+            if(ok) parse_block(record, sealed.block, sealed.seal, sealed.transactions);
+        }
+        if(!ok || sealed.block.hash != entry.hash) throw std::runtime_error("block index does not match the chain store");
+        return sealed;
+    }
+
+    // Switches the active tip to `target` on another branch. The old branch is
+    // disconnected newest first (ledger undo records; its transactions go back
+    // to the mempool), then the new one is connected oldest first.
+    qfunc reorganize(uint32_t target) -> QubistBool {
+        uint32_t old_tip = index.active();
+        uint32_t fork = index.fork_point(old_tip, target);
+        uint32_t fork_height = fork == BlockIndex::none ? 0 : index[fork].height;
+        uint32_t depth = index[old_tip].height - fork_height;
+        if(depth > QuantumLedger::max_undo) {
+            std::cout << "[!] Heavier branch forks " << depth << " blocks below the tip (limit "
+                      << QuantumLedger::max_undo << "); staying on tip #" << index[old_tip].height << std::endl;
+            return false;
+        }
+        writer->drain();
+       
+        std::vector<QuantumTransaction> returned;
+        for(uint32_t e = old_tip; e != fork; e = index[e].parent) {
+            SealedBlock old_block = load_block(index[e]);
+            if(ledger) ledger->disconnect_block(index[e].hash);
+            for(auto& tx : old_block.transactions) returned.push_back(std::move(tx));
+        }
+       
+        std::vector<uint32_t> branch;
+        for(uint32_t e = target; e != fork; e = index[e].parent) branch.push_back(e);
+        std::unordered_set<TxId, Hash256::Hasher> confirmed;
+        for(auto it = branch.rbegin(); it != branch.rend(); ++it) {
+            SealedBlock new_block = load_block(index[*it]);
+            if(ledger) ledger->connect_block(index[*it].hash, new_block.transactions, payout_agent, new_block.block.reward);
+            mempool.remove(new_block.transactions);
+            for(const auto& tx : new_block.transactions) confirmed.insert(tx.id);
+        }
+       
+        QubistInt requeued = 0;
+        QubistInt dropped = 0;
+        for(const auto& tx : returned) {
+            if(confirmed.count(tx.id)) continue;
+            try {
+                submit_transaction(tx);
+                requeued++;
+            } catch(const std::invalid_argument& e) {
+                dropped++;
+                std::cout << "[!] Transaction " << tx.id.to_hex().substr(0, 16) << " dropped by reorg: " << e.what() << std::endl;
+            }
+        }
+       
+        index.set_active(target);
+        move_tip(target);
+        std::cout << "🔀 Reorg to #" << index[target].height << ": " << depth << " blocks disconnected, "
+                  << branch.size() << " connected, " << requeued << " transactions back in the mempool";
+        if(dropped) std::cout << ", " << dropped << " dropped";
+        std::cout << std::endl;
+        return true;
+    }
+
+    // Lowest nonce in [0, 2^32) meeting `target`, or NonceSearch::not_found
+    qfunc search_header(const QuantumBlockHeader& header, const QuantumTarget& target) -> QubistInt {
+        return (this->*search_fn)(header, target);
+    }
+
+    template <typename Hash, typename Check>
+    qfunc search_with(const QuantumBlockHeader& header, const QuantumTarget& target) -> QubistInt {
+        if(!Hash::uses_midstate || hash_path == "full") {
+            return NonceSearch::run([&](QubistInt candidate) {
+                QuantumBlockHeader attempt = header;
+                attempt.nonce = uint32_t(candidate);
+                unsigned char digest[32];
+                Hash::hash(attempt, digest);
+                return Check::first_hit(target, digest, 1) == 0;
+            }, mining_threads, nonce_space, hash_counters(), &throttle);
+        }
+
+        QuantumMidstate midstate(header);
+        return NonceSearch::run_batched([&](QubistInt first) {
+            unsigned char digests[16 * 32];
+            HashKernels::hash_batch(hash_kernel, midstate, uint32_t(first), digests);
+            for(unsigned l = 0; l < hash_kernel.lanes; l++) Hash::finish(digests + 32 * l);
+            unsigned hit = Check::first_hit(target, digests, hash_kernel.lanes);
+            return hit < hash_kernel.lanes ? first + hit : NonceSearch::not_found;
+        }, mining_threads, hash_kernel.lanes, nonce_space, hash_counters(), &throttle);
+    }
+
+    qfunc hash_counters() -> Telemetry::Counter* {
+        return telemetry ? telemetry->thread_hashes() : nullptr;
+    }
+
+    qfunc resume_from_chain() -> void {
+        if(chain_store == "binary") {
+            StoredBlock tip;
+            if(BlockStore::recover_tip(block_dir, tip)) {
+                current_height = QubistInt(tip.height);
+                tip_hash = tip.hash;
+                tip_time = tip.header.time;
+                block_target = QuantumTarget::from_compact(tip.header.bits);
+            }
+            return;
+        }
+        resume_from_jsonl();
+    }
+
+    qfunc index_path() const -> QubistString {
+        return chain_store == "binary" ? block_dir + "/index.dat" : chain_file + ".index";
+    }
+
+    // Visits stored records from location `from` as fn(stored, location); JSONL
+    // records only fill the fields the index needs. JSONL lines that are not
+    // blocks of this format (records from before the binary header) are
+    // counted in `skipped` and passed over.
+    template <typename Visitor>
+    qfunc scan_store(uint64_t from, Visitor fn, QubistInt& skipped) const -> void {
+        if(chain_store == "binary") {
+            BlockStore::for_each_from(block_dir, from, [&](const StoredBlock& stored, std::string_view, uint64_t at) {
+                fn(stored, at);
+                return true;
+            });
+            return;
+        }
+        std::ifstream chain(chain_file, std::ios::binary);
+        chain.seekg(std::streamoff(from));
+        std::string line;
+        for(uint64_t at = from; std::getline(chain, line); at += line.size() + 1) {
+            if(line.empty()) continue;
+            StoredBlock stored;
+            try {
+                QubistDict block = json::parse(line);
+                stored.height = uint64_t(QubistInt(block["height"]));
+                stored.hash = Hash256::from_hex(QubistString(block["hash"]));
+                stored.header.previous_hash = Hash256::from_hex(QubistString(block["previous_hash"]));
+                stored.header.bits = block.count("bits") ? uint32_t(QubistInt(block["bits"])) : block_target.bits();
+                stored.header.time = block.count("timestamp") ? uint32_t(QubistInt(block["timestamp"])) : 0;
+            } catch(const std::exception&) {
+                skipped++;
+                continue;
+            }
+            fn(stored, at);
+        }
+    }
+
+    // Loads the saved index and indexes only what the store gained since it
+    // was written, so startup does not rescan the chain. Without a usable
+    // index file (missing, older format, or out of step with the store) the
+    // whole store is indexed again.
+    qfunc open_index() -> void {
+        uint64_t end = writer->end();
+        std::optional<uint64_t> covered = index.load(index_path());
+        QubistInt added = 0, orphans = 0, skipped = 0;
+        auto index_from = [&](uint64_t from) {
+            scan_store(from, [&](const StoredBlock& stored, uint64_t at) {
+                if(index.find(stored.hash) != BlockIndex::none) return;
+                uint32_t parent = index.find(stored.header.previous_hash);
+                if(parent == BlockIndex::none && stored.header.previous_hash != Hash256{}) orphans++;
+                index.add(stored.hash, parent, uint32_t(stored.height), stored.header.bits, stored.header.time, at);
+                added++;
+            }, skipped);
+        };
+        auto rebuild = [&]() {
+            index.clear();
+            added = orphans = skipped = 0;
+            index_from(0);
+        };
+       
+        try {
+            // A saved index whose tail lands mid-record, or that gained only
+            // unreadable records, belongs to some other store
+            if(!covered || *covered > end) {
+                rebuild();
+            } else {
+                index_from(*covered);
+                if(skipped > 0 && *covered > 0) {
+                    std::cout << "[!] Block index out of step with the store; rebuilding" << std::endl;
+                    rebuild();
+                }
+            }
+        } catch(const std::exception& e) {
+            std::cout << "[!] Block index out of step with the store (" << e.what() << "); rebuilding" << std::endl;
+            try {
+                rebuild();
+            } catch(const std::exception& again) {
+                std::cout << "[!] Block index stopped at an unreadable record: " << again.what() << std::endl;
+            }
+        }
+        if(skipped > 0) std::cout << "[!] Block index: " << skipped << " legacy or unreadable records skipped" << std::endl;
+       
+        // Records past the saved index were appended by a run that exited
+        // without saving it; that run had already booked the heaviest of them
+        if(index.active() == BlockIndex::none ||
+           (added > 0 && index[index.active()].work < index[index.best()].work)) {
+            index.set_active(index.best());
+        }
+        if(added > 0) {
+            std::cout << "🗂️  Block index: " << added << " blocks indexed";
+            if(orphans > 0) std::cout << " (" << orphans << " with unknown parents)";
+            std::cout << std::endl;
+        }
+        if(index.active() != BlockIndex::none) move_tip(index.active());
+    }
+
+    // Recovers tip height and hash from the last chain record by reading
+    // backwards from EOF, so startup cost does not grow with the chain. A torn
+    // final record (crash mid-append) is cut off so the next append starts clean.
+    qfunc resume_from_jsonl() -> void {
+        if(!std::filesystem::exists(chain_file)) return;
+       
+        std::ifstream chain(chain_file, std::ios::binary);
+        chain.seekg(0, std::ios::end);
+        std::streamoff file_end = chain.tellg();
+        std::streamoff pos = file_end;
+        std::streamoff line_end = -1;     // '\n' closing the last record
+        std::streamoff line_begin = 0;
+        char buffer[4096];
+       
+        while(pos > 0) {
+            std::streamoff n = std::min<std::streamoff>(sizeof(buffer), pos);
+            pos -= n;
+            chain.seekg(pos);
+            chain.read(buffer, n);
+           
+            bool found = false;
+            for(std::streamoff i = n - 1; i >= 0 && !found; i--) {
+                if(buffer[i] != '\n') continue;
+                if(line_end < 0 || pos + i + 1 == line_end) {
+                    line_end = pos + i;   // last newline, or an empty line before it
+                } else {
+                    line_begin = pos + i + 1;
+                    found = true;
+                }
+            }
+            if(found) break;
+        }
+        chain.close();
+       
+        if(line_end + 1 < file_end) {
+            std::cout << "[!] Dropping torn record at end of " << chain_file << std::endl;
+            std::filesystem::resize_file(chain_file, line_end < 0 ? 0 : line_end + 1);
+        }
+        if(line_end <= line_begin) return;
+       
+        std::string record(line_end - line_begin, '\0');
+        std::ifstream tail(chain_file, std::ios::binary);
+        tail.seekg(line_begin);
+        tail.read(record.data(), record.size());
+       
+        // A legacy last record leaves the tip to the index
+        try {
+            QubistDict tip = json::parse(record);
+            Hash256 hash = Hash256::from_hex(QubistString(tip["hash"]));
+            current_height = tip["height"];
+            tip_hash = hash;
+            if(tip.count("timestamp")) tip_time = uint32_t(QubistInt(tip["timestamp"]));
+            if(tip.count("bits")) block_target = QuantumTarget::from_compact(uint32_t(QubistInt(tip["bits"])));
+        } catch(const std::exception& e) {
+            std::cout << "[!] Last record of " << chain_file << " is not a block of this format: " << e.what() << std::endl;
+        }
+    }
+
+public:
+    qfunc QuantumMiner(const BlockchainSettings& settings = BlockchainSettings::load())
+        : chain_file(settings.file), block_reward(settings.reward), payout_agent(settings.payout_agent),
+          block_target(settings.initial_target()),
+          retarget(settings.target_block_time, settings.retarget_window, settings.max_retarget_factor),
+          max_block_bytes(size_t(std::max<QubistInt>(0, settings.max_block_bytes))),
+          snapshot_interval(std::max<QubistInt>(0, settings.snapshot_interval)) {
+        set_hash_policy(settings.hash_function, target_check);
+    }
+
+    // The index is saved once the writer has drained, so it covers every record
+    qfunc ~QuantumMiner() {
+        if(!writer) return;
+        uint64_t end = writer->end();
+        writer.reset();
+        try {
+            index.save(index_path(), end);
+        } catch(const std::exception& e) {
+            std::cout << "[!] " << e.what() << std::endl;
+        }
+    }
+
+    static qfunc transaction_to_json(const QuantumTransaction& tx) -> QubistDict {
+        return QubistDict{
+            {"id", tx.id.to_hex()},
+            {"kind", tx.kind == QuantumTransaction::grant ? "grant" : "transfer"},
+            {"from", tx.from},
+            {"to", tx.to},
+            {"amount", tx.amount},
+            {"fee", tx.fee},
+            {"timestamp", QubistInt(tx.timestamp)}
+        };
+    }
+
+    // Missing timestamp means "now"; the id is always recomputed
+    static qfunc transaction_from_json(QubistDict& entry) -> QuantumTransaction {
+        QuantumTransaction tx;
+        QubistString kind = entry["kind"];
+        if(kind == "grant") tx.kind = QuantumTransaction::grant;
+        else if(kind == "transfer") tx.kind = QuantumTransaction::transfer;
+        else throw std::invalid_argument("unknown transaction kind: " + kind);
+        if(entry.count("from")) tx.from = QubistString(entry["from"]);
+        tx.to = QubistString(entry["to"]);
+        tx.amount = entry["amount"];
+        tx.fee = entry.count("fee") ? QubistFloat(entry["fee"]) : 0.0;
+        tx.timestamp = entry.count("timestamp") ? uint64_t(QubistInt(entry["timestamp"]))
+                                                : uint64_t(Simulation::unix_ms());
+        tx.seal();
+        return tx;
+    }
+
+    // Transfers are checked against the connected ledger and what the sender
+    // already has pending; both ends must be known agents
+    qfunc submit_transaction(const QuantumTransaction& tx) -> TxId {
+        if(!ledger) throw std::invalid_argument("no ledger connected");
+        if(!ledger->has_agent(tx.to)) throw std::invalid_argument("unknown agent " + tx.to);
+        QubistFloat balance = 0.0;
+        if(tx.kind == QuantumTransaction::transfer) {
+            auto sender = ledger->balance_of(tx.from);
+            if(!sender) throw std::invalid_argument("unknown agent " + tx.from);
+            balance = *sender;
+        }
+        return mempool.submit(tx, balance);
+    }
+
+    qfunc pending_transactions() const -> const Mempool& {
+        return mempool;
+    }
+
+    qfunc connect_ledger(QuantumLedger& agents) -> void {
+        ledger = &agents;
+    }
+
+    qfunc set_snapshot_interval(QubistInt blocks) -> void {
+        snapshot_interval = std::max<QubistInt>(0, blocks);
+    }
+
+    // Writes the connected ledger's balances as of the active tip
+    qfunc take_snapshot() -> QubistString {
+        chain_writer();
+        if(!ledger) throw std::invalid_argument("no ledger connected");
+        if(index.active() == BlockIndex::none) throw std::invalid_argument("chain is empty");
+        StateSnapshot snapshot;
+        snapshot.height = index[index.active()].height;
+        snapshot.tip = index[index.active()].hash;
+        snapshot.balances = ledger->balances();
+        QubistString path = snapshot.save();
+        std::cout << "📸 Snapshot at #" << snapshot.height << ": " << snapshot.balances.size() << " balances -> " << path << std::endl;
+        return path;
+    }
+
+    // Rebuilds the ledger balances from the newest snapshot on the active
+    // chain, replaying only the blocks after it (all of them from the genesis
+    // snapshot without one). Refuses when neither is usable: starting from
+    // zero would wipe balances no block ever booked.
+    qfunc restore_ledger() -> void {
+        chain_writer();
+        if(!ledger) throw std::invalid_argument("no ledger connected");
+        auto started = Simulation::now();
+        uint32_t active = index.active();
+       
+        StateSnapshot snapshot;
+        uint32_t base = BlockIndex::none;
+        for(const QubistString& path : StateSnapshot::available()) {
+            try {
+                StateSnapshot candidate = StateSnapshot::load(path);
+                uint32_t entry = index.find(candidate.tip);
+                if(entry == BlockIndex::none || index.fork_point(active, entry) != entry) continue;    // not on our chain
+                snapshot = std::move(candidate);
+                base = entry;
+                break;
+            } catch(const std::exception& e) {
+                std::cout << "[!] Skipping snapshot: " << e.what() << std::endl;
+            }
+        }
+        if(base == BlockIndex::none) {
+            if(!std::filesystem::exists(StateSnapshot::genesis_path())) {
+                throw std::invalid_argument("no snapshot on the active chain and no genesis snapshot to replay from");
+            }
+            snapshot = StateSnapshot::load(StateSnapshot::genesis_path());
+        }
+       
+        std::vector<uint32_t> replay;
+        for(uint32_t e = active; e != base && e != BlockIndex::none; e = index[e].parent) replay.push_back(e);
+        ledger->restore_balances(snapshot.balances);
+        for(auto it = replay.rbegin(); it != replay.rend(); ++it) {
+            SealedBlock block = load_block(index[*it]);
+            ledger->connect_block(index[*it].hash, block.transactions, payout_agent, block.block.reward, false);
+        }
+        ledger->flush();
+       
+        auto elapsed = std::chrono::duration<double>(Simulation::now() - started).count();
+        std::cout << "♻️  Ledger restored from " << (base == BlockIndex::none ? QubistString("genesis")
+                                                       : "snapshot #" + std::to_string(snapshot.height))
+                  << " + " << replay.size() << " blocks replayed in " << elapsed << "s" << std::endl;
+    }
+
+    // Empties binary store segments holding only blocks below `height`. The
+    // newest segment is always kept, and so are the last max_undo blocks
+    // under `height` so reorgs can still read them.
+    qfunc prune_store(uint64_t height) -> void {
+        chain_writer();
+        if(chain_store != "binary") throw std::invalid_argument("pruning needs --store binary");
+        uint64_t keep_from = height > QuantumLedger::max_undo ? height - QuantumLedger::max_undo : 0;
+        int segments = BlockStore::segment_count(block_dir);
+        std::vector<uint64_t> highest(size_t(std::max(segments, 0)), 0);
+        for(uint32_t i = 0; i < index.size(); i++) {
+            auto segment = size_t(BlockStore::location_segment(index[i].location));
+            if(segment < highest.size()) highest[segment] = std::max<uint64_t>(highest[segment], index[i].height);
+        }
+       
+        QubistInt pruned = 0;
+        uintmax_t freed = 0;
+        for(int i = 0; i + 1 < segments; i++) {
+            QubistString path = BlockStore::segment_path(block_dir, i);
+            uintmax_t size = std::filesystem::file_size(path);
+            if(size == 0 || highest[size_t(i)] >= keep_from) continue;
+            std::filesystem::resize_file(path, 0);      // placeholder keeps segment numbering
+            pruned++;
+            freed += size;
+        }
+        std::cout << "✂️  Pruned " << pruned << " segments below #" << keep_from << " (" << freed / 1048576.0
+                  << " MiB freed)" << std::endl;
+    }
+
+    // JSON rendering shared by the JSONL store and export-jsonl
+    static qfunc render_block(const StoredBlock& stored, const BlockSeal* seal = nullptr,
+                              const std::vector<QuantumTransaction>* transactions = nullptr) -> QubistDict {
+        QuantumTarget target = QuantumTarget::from_compact(stored.header.bits);
+        QubistDict block = {
+            {"height", QubistInt(stored.height)},
+            {"hash", stored.hash.to_hex()},
+            {"previous_hash", stored.header.previous_hash.to_hex()},
+            {"version", QubistInt(stored.header.version)},
+            {"merkle_root", stored.header.merkle_root.to_hex()},
+            {"timestamp", QubistInt(stored.header.time)},
+            {"nonce", QubistInt(stored.header.nonce)},
+            {"difficulty", target.difficulty()},
+            {"bits", QubistInt(stored.header.bits)},
+            {"mining_time", stored.mining_time},
+            {"reward", stored.reward},
+            {"miner_address", "quantum_miner_" + std::to_string(Hash256::Hasher{}(stored.hash))},
+            {"quantum_state", "superposition|mined⟩"}
+        };
+        if(transactions && !transactions->empty()) {
+            QubistList rendered;
+            for(const auto& tx : *transactions) rendered.push_back(transaction_to_json(tx));
+            block["transactions"] = rendered;
+        }
+        if(seal) {
+            block["public_key"] = format_quantum_hash(seal->public_key, sizeof(seal->public_key));
+            block["signature"] = format_quantum_hash(seal->signature, sizeof(seal->signature));
+        }
+        return block;
+    }
+
+    // Hex for the fixed-size blobs that are not digests: headers, keys, signatures
+    static qfunc format_quantum_hash(const unsigned char* bytes, size_t length) -> QubistString {
+        QubistString hex(2 * length, '\0');
+        Hex::encode(bytes, length, hex.data());
+        return hex;
+    }
+
+    static qfunc parse_quantum_hash(const QubistString& hex, unsigned char* bytes, size_t length) -> void {
+        if(hex.size() != 2 * length || !Hex::decode(hex.data(), length, bytes)) {
+            throw std::invalid_argument("malformed hex field: " + hex);
+        }
+    }
+
+    qfunc set_mining_threads(unsigned threads) -> void {
+        mining_threads = std::max(1u, threads);
+    }
+
+    qfunc thread_count() const -> unsigned { return mining_threads; }
+    qfunc search_throttle() -> NonceSearch::Throttle& { return throttle; }
+
+    // Called on the mining thread after each block of continuous_mining
+    qfunc set_block_hook(std::function<void()> hook) -> void { block_hook = std::move(hook); }
+
+    // Hashes tried since this miner's telemetry was created
+    qfunc hashes_done() const -> uint64_t {
+        return telemetry ? telemetry->total_hashes() : 0;
+    }
+
+    qfunc set_hash_path(QubistString path) -> void {
+        if(path != "midstate" && path != "full") {
+            throw std::invalid_argument("unknown hash path: " + path);
+        }
+        hash_path = path;
+    }
+
+    qfunc set_hash_kernel(QubistString name) -> void {
+        hash_kernel = HashKernels::by_name(name);
+    }
+
+    // Binds the search loop and block hash for a (chain hash, target check) pair
+    qfunc set_hash_policy(QubistString hash, QubistString check) -> void {
+        with_hash_policy(hash, [&]<typename Hash>() {
+            with_target_check(check, [&]<typename Check>() {
+                search_fn = &QuantumMiner::search_with<Hash, Check>;
+            });
+            hash_fn = &Hash::hash;
+        });
+        chain_hash = hash;
+        target_check = check;
+    }
+
+    qfunc hash_policy() const -> const QubistString& {
+        return chain_hash;
+    }
+
+    qfunc hash_header(const QuantumBlockHeader& header) const -> Hash256 {
+        return generate_quantum_hash(header);
+    }
+
+    qfunc set_durability(const DurabilityPolicy& policy) -> void {
+        durability = policy;
+    }
+
+    qfunc set_chain_store(QubistString store) -> void {
+        if(store != "jsonl" && store != "binary") {
+            throw std::invalid_argument("unknown chain store: " + store);
+        }
+        chain_store = store;
+    }
+
+    // Opening the chain recovers the tip first, so the store can be chosen
+    // after construction
+    qfunc chain_writer() -> ChainWriter& {
+        if(!writer) {
+            resume_from_chain();
+            writer = chain_store == "binary"
+                ? std::make_unique<ChainWriter>(block_dir, BlockStore::segment_bytes, durability)
+                : std::make_unique<ChainWriter>(chain_file, 0, durability);
+            open_index();
+            if(pending_target) {
+                block_target = *pending_target;     // overrides the resumed tip's target
+                pending_target.reset();
+            }
+            key_pool = std::make_unique<KeypairPool>();
+            try {
+                telemetry = MiningTelemetry::create(MiningTelemetry::default_path, mining_threads);
+            } catch(const std::exception& e) {
+                std::cout << "[!] Telemetry disabled: " << e.what() << std::endl;
+            }
+        }
+        return *writer;
+    }
+
+    // Applied once the chain is resumed, so the tip's target cannot override it
+    qfunc set_target(const QuantumTarget& target) -> void {
+        if(writer) block_target = target;
+        else pending_target = target;
+    }
+
+    qfunc set_retargeting(QubistBool enabled) -> void {
+        retargeting = enabled;
+    }
+
+    // The tip's target, read under the tip lock
+    qfunc running_target() const -> QuantumTarget {
+        std::lock_guard<std::mutex> lock(tip_mutex);
+        return block_target;
+    }
+
+    qfunc current_target() const -> const QuantumTarget& {
+        return pending_target ? *pending_target : block_target;
+    }
+
+    // Mines at the running target; finish_block retargets for the next one
+    qfunc mine_block() -> QubistDict {
+        chain_writer();
+        return mine_block(running_target());
+    }
+
+    qfunc mine_block(QubistInt difficulty) -> QubistDict {
+        return mine_block(QuantumTarget::from_hex_zeros(difficulty));
+    }
+
+    qfunc mine_block(const QuantumTarget& target) -> QubistDict {
+        chain_writer();
+        BlockTemplate tmpl = prepare_template(current_height + 1);
+        return publish(solve_template(tmpl, target));
+    }
+
+    // Pool mode: the next block's template, linked to the tip at the running target
+    qfunc open_template() -> BlockTemplate {
+        chain_writer();
+        BlockTemplate tmpl = prepare_template(current_height + 1);
+        link_template(tmpl, running_target());
+        return tmpl;
+    }
+
+    // Hands an unsolved template's transactions back to the mempool
+    qfunc release_template(BlockTemplate& tmpl) -> void {
+        mempool.restore(tmpl.transactions);
+        tmpl.transactions.clear();
+    }
+
+    // Pool mode: appends a template whose time/nonce were solved elsewhere.
+    // The caller has already checked the header against its bits.
+    qfunc accept_block(BlockTemplate& tmpl, QubistFloat duration) -> QubistDict {
+        return publish(finish_block(tmpl, duration));
+    }
+   
+    // A block mined elsewhere, as a JSONL record: "tip" if it moved the active
+    // tip, "side", "duplicate", "orphan" (parent not stored) or "invalid"
+    qfunc import_block(const QubistString& record) -> QubistString {
+        chain_writer();
+        SealedBlock sealed;
+        try {
+            bool has_seal = parse_block(record, sealed.block, sealed.seal, sealed.transactions);
+            if(const char* reason = check_block(sealed.block, has_seal ? &sealed.seal : nullptr, sealed.transactions)) {
+                std::cout << "❌ Block #" << sealed.block.height << " rejected: " << reason << std::endl;
+                return "invalid";
+            }
+            if(!has_seal) return "invalid";
+        } catch(const std::exception& e) {
+            std::cout << "❌ Block rejected: " << e.what() << std::endl;
+            return "invalid";
+        }
+       
+        const StoredBlock& stored = sealed.block;
+        if(index.find(stored.hash) != BlockIndex::none) return "duplicate";
+        uint32_t parent = index.find(stored.header.previous_hash);
+        if(parent == BlockIndex::none && stored.header.previous_hash != Hash256{}) return "orphan";
+        if(stored.height != (parent == BlockIndex::none ? 1 : index[parent].height + 1)) return "invalid";
+        const char* reason = nullptr;
+        if(stored.header.time > Simulation::unix_time() + max_time_drift) reason = "timestamp too far in the future";
+        else if(parent != BlockIndex::none && stored.header.time < index[parent].time) reason = "timestamp before its parent's";
+        else if(parent != BlockIndex::none && stored.header.bits != expected_target(parent).bits()) {
+            reason = "bits differ from the retargeted target";
+        }
+        if(reason) {
+            std::cout << "❌ Block #" << stored.height << " rejected: " << reason << std::endl;
+            return "invalid";
+        }
+       
+        uint32_t active = index.active();
+        publish(sealed, false);
+        return index.active() != active ? "tip" : "side";
+    }
+   
+    qfunc continuous_mining(QubistInt blocks_to_mine = 10) -> void {
+        std::cout << "🚀 Starting continuous quantum mining..." << std::endl;
+        ChainWriter& chain = chain_writer();
+       
+        // No pause between blocks: cadence comes from retargeting, not sleeps.
+        // Seeded runs build each template in turn so its timing is reproducible.
+        auto overlap = Simulation::enabled() ? std::launch::deferred : std::launch::async;
+        {
+            BlockPublisher publisher([this](const SealedBlock& sealed) { publish(sealed); });
+            auto next = std::async(overlap, [this, height = current_height + 1]() {
+                return prepare_template(height);
+            });
+           
+            for(QubistInt i = 0; i < blocks_to_mine; i++) {
+                BlockTemplate tmpl = next.get();
+                if(i + 1 < blocks_to_mine) {
+                    next = std::async(overlap, [this, height = tmpl.height + 1]() {
+                        return prepare_template(height);
+                    });
+                }
+               
+                publisher.publish(solve_template(tmpl, running_target()));
+                if(block_hook) block_hook();
+                if(throttle.halted.load(std::memory_order_relaxed)) {
+                    std::cout << "⚡ Energy budget spent: stopping after " << i + 1 << " blocks" << std::endl;
+                    break;
+                }
+            }
+            // A prefetched template nobody will mine (a deferred one was never built)
+            if(next.valid() && next.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+                BlockTemplate unused = next.get();
+                release_template(unused);
+            }
+        }
+       
+        if(Simulation::enabled()) chain.drain();
+        QubistDict io = chain.stats();
+        std::cout << "💾 Chain writer: queue depth " << io["queue_depth"]
+                  << " | flush avg " << io["flush_ms_avg"] << "ms, max " << io["flush_ms_max"] << "ms" << std::endl;
+        std::cout << "🔑 Keypair pool: " << key_pool->miss_count() << " inline keygens" << std::endl;
+    }
+   
+    // Streams the chain store in batches: per-block checks (PoW, coinbase,
+    // reward, signature) and JSON parsing fan out across mining_threads, then
+    // each block's parent must already be stored and its height follow it.
+    // Side branches are valid. Stops at the first bad block.
+    qfunc verify_chain() -> QubistDict {
+        struct Pending {
+            QubistString record;      // JSONL only; parsed by the worker
+            StoredBlock block;
+            BlockSeal seal;
+            bool sealed = false;
+            std::vector<QuantumTransaction> transactions;
+            const char* error = nullptr;
+        };
+        constexpr size_t batch_size = 1 << 16;
+
+        std::vector<Pending> batch;
+        batch.reserve(batch_size);
+        QubistInt valid = 0;
+        BlockIndex seen;
+        QubistInt first_invalid = -1;
+        // A pruned store starts mid-chain; its first block's parent was checked before pruning
+        bool pruned = chain_store == "binary" && BlockStore::segment_count(block_dir) > 0 &&
+                      std::filesystem::file_size(BlockStore::segment_path(block_dir, 0)) == 0;
+        QubistString reason;
+
+        auto verify_batch = [&]() -> bool {
+            NonceSearch::for_each_index(batch.size(), mining_threads, [&](size_t i) {
+                Pending& p = batch[i];
+                try {
+                    if(!p.record.empty()) p.sealed = parse_block(p.record, p.block, p.seal, p.transactions);
+                    p.error = check_block(p.block, p.sealed ? &p.seal : nullptr, p.transactions);
+                } catch(const std::exception&) {
+                    p.error = "malformed record";
+                }
+            });
+
+            for(Pending& p : batch) {
+                const Hash256& previous = p.block.header.previous_hash;
+                uint32_t parent = seen.find(previous);
+                bool root = pruned && seen.size() == 0;
+                if(!p.error && !root && parent == BlockIndex::none && previous != Hash256{}) p.error = "parent hash does not link";
+                if(!p.error && !root && p.block.height != (parent == BlockIndex::none ? 1 : seen[parent].height + 1)) {
+                    p.error = "height does not follow parent";
+                }
+                if(!p.error && seen.find(p.block.hash) != BlockIndex::none) p.error = "duplicate block";
+                if(p.error) {
+                    first_invalid = QubistInt(p.block.height);
+                    reason = p.error;
+                    return false;
+                }
+                seen.add(p.block.hash, parent, uint32_t(p.block.height), p.block.header.bits, p.block.header.time, 0);
+                valid++;
+            }
+            batch.clear();
+            return true;
+        };
+
+        auto start = Simulation::now();
+        if(chain_store == "binary") {
+            BlockStore::for_each(block_dir, [&](const StoredBlock& stored, std::string_view extension) {
+                Pending& p = batch.emplace_back();
+                p.block = stored;
+                p.sealed = BlockSeal::from_extension(extension, p.seal);
+                if(!decode_transactions(extension, p.transactions)) p.error = "malformed transactions";
+                return batch.size() < batch_size || verify_batch();
+            });
+        } else {
+            std::ifstream chain(chain_file);
+            std::string line;
+            while(std::getline(chain, line)) {
+                if(line.empty()) continue;
+                batch.emplace_back().record = std::move(line);
+                if(batch.size() == batch_size && !verify_batch()) break;
+            }
+        }
+        if(first_invalid < 0 && !batch.empty()) verify_batch();
+        auto elapsed = std::chrono::duration<double>(Simulation::now() - start).count();
+
+        QubistInt best_height = seen.size() ? QubistInt(seen[seen.best()].height) : 0;
+        QubistInt first_height = pruned && seen.size() ? QubistInt(seen[0].height) : 1;
+        QubistInt side_blocks = seen.size() ? valid - (best_height - first_height + 1) : 0;
+        QubistDict report = {
+            {"blocks_valid", valid},
+            {"best_height", best_height},
+            {"side_blocks", side_blocks},
+            {"first_height", first_height},
+            {"first_invalid_height", first_invalid},
+            {"reason", reason},
+            {"threads", QubistInt(mining_threads)},
+            {"seconds", elapsed},
+            {"blocks_per_s", elapsed > 0 ? valid / elapsed : 0.0}
+        };
+        if(first_invalid < 0) {
+            std::cout << "✅ Chain valid: " << valid << " blocks";
+            if(side_blocks > 0) std::cout << " (best tip #" << best_height << ", " << side_blocks << " side blocks)";
+            if(first_height > 1) std::cout << " from #" << first_height << " (pruned below)";
+        } else {
+            std::cout << "❌ First invalid block: #" << first_invalid << " (" << reason << ") after "
+                      << valid << " valid blocks";
+        }
+        std::cout << " | " << elapsed << "s, " << report["blocks_per_s"] << " blocks/s on "
+                  << mining_threads << " threads" << std::endl;
+        return report;
+    }
+   
+    // Rewrites the binary store as JSONL for the Python tooling
+    qfunc export_jsonl(QubistString out_file) -> void {
+        QubistString tmp_file = out_file + ".tmp";
+        std::ofstream out(tmp_file, std::ios::trunc);
+       
+        auto start = Simulation::now();
+        QubistInt exported = BlockStore::for_each(block_dir, [&](const StoredBlock& stored, std::string_view extension) {
+            BlockSeal seal;
+            std::vector<QuantumTransaction> transactions;
+            bool sealed = BlockSeal::from_extension(extension, seal);
+            decode_transactions(extension, transactions);
+            out << json::dump(render_block(stored, sealed ? &seal : nullptr, &transactions)) << '\n';
+            return true;
+        });
+        out.close();
+        std::filesystem::rename(tmp_file, out_file);
+       
+        auto elapsed = std::chrono::duration<double>(Simulation::now() - start).count();
+        std::cout << "📤 Exported " << exported << " blocks from " << block_dir << " to " << out_file
+                  << " in " << elapsed << "s" << std::endl;
+    }
+};
+
+// ==================== MINING POOL ====================
+// `pool` serves work to `worker` processes as newline-delimited JSON over a
+// TCP or UNIX socket, stratum style. Each job hands out a disjoint nonce range
+// of the current template; once the 32-bit space is handed out the pool rolls
+// the header time (the header has no extranonce field) and starts over.
+// Workers report shares at an easier target and blocks at the real one; the
+// pool re-hashes every submission and is the only process that appends.
+// Clients may also send grant/transfer transactions into the pool's mempool.
+// Every connection proves a shared secret (--secret or the environment
+// variable below) in its first message; the pool drops any that does not.
+namespace Stratum {
+
+constexpr size_t max_line = 1 << 20;      // a full block relayed as JSON
+constexpr const char* secret_variable = "SATOSHI_MIRROR_POOL_SECRET";
+
+// Compares digests of the two secrets without an early exit, so the reply
+// time says nothing about how much of a guess was right
+static qfunc same_secret(const QubistString& offered, const QubistString& expected) -> QubistBool {
+    Hash256 a = Hash256::of(offered.data(), offered.size());
+    Hash256 b = Hash256::of(expected.data(), expected.size());
+    uint8_t difference = 0;
+    for(size_t i = 0; i < 32; i++) difference |= a[i] ^ b[i];
+    return difference == 0;
+}
+
+// "unix:/path", "tcp:host:port" or "host:port"
+struct Endpoint {
+    QubistBool unix_socket = false;
+    QubistString path;
+    QubistString host = "127.0.0.1";
+    QubistString port = "3333";
+
+    static qfunc parse(const QubistString& spec) -> Endpoint {
+        Endpoint endpoint;
+        if(spec.rfind("unix:", 0) == 0) {
+            endpoint.unix_socket = true;
+            endpoint.path = spec.substr(5);
+            return endpoint;
+        }
+        QubistString address = spec.rfind("tcp:", 0) == 0 ? spec.substr(4) : spec;
+        size_t colon = address.rfind(':');
+        if(colon == QubistString::npos) throw std::invalid_argument("endpoint needs host:port: " + spec);
+        endpoint.host = address.substr(0, colon);
+        endpoint.port = address.substr(colon + 1);
+        return endpoint;
+    }
+
+    qfunc describe() const -> QubistString {
+        return unix_socket ? "unix:" + path : "tcp:" + host + ":" + port;
+    }
+};
+
+// Listening or connected stream socket for `endpoint`
+static qfunc open_socket(const Endpoint& endpoint, QubistBool listening) -> int {
+    int fd = -1;
+    int rc = -1;
+    if(endpoint.unix_socket) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if(endpoint.path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("socket path too long");
+        std::memcpy(addr.sun_path, endpoint.path.c_str(), endpoint.path.size());
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(listening) ::unlink(endpoint.path.c_str());
+        if(fd >= 0) {
+            rc = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+                           : ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+    } else {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        addrinfo* found = nullptr;
+        if(::getaddrinfo(endpoint.host.c_str(), endpoint.port.c_str(), &hints, &found) != 0 || !found) {
+            throw std::runtime_error("cannot resolve " + endpoint.describe());
+        }
+        fd = ::socket(found->ai_family, found->ai_socktype | SOCK_CLOEXEC, found->ai_protocol);
+        if(fd >= 0) {
+            int one = 1;
+            if(listening) {
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                rc = ::bind(fd, found->ai_addr, found->ai_addrlen);
+            } else {
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                rc = ::connect(fd, found->ai_addr, found->ai_addrlen);
+            }
+        }
+        ::freeaddrinfo(found);
+    }
+
+    if(rc == 0 && listening) rc = ::listen(fd, 64);
+    if(rc != 0) {
+        QubistString error = std::strerror(errno);
+        if(fd >= 0) ::close(fd);
+        throw std::runtime_error((listening ? "cannot listen on " : "cannot connect to ") +
+                                 endpoint.describe() + ": " + error);
+    }
+    return fd;
+}
+
+// One JSON message per line over a connected socket
+class Connection {
+private:
+    int fd;
+    std::string inbox;
+
+public:
+    qfunc Connection(int socket) : fd(socket) {}
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    qfunc ~Connection() {
+        ::close(fd);
+    }
+
+    qfunc descriptor() const -> int { return fd; }
+
+    qfunc send(const QubistDict& message) -> QubistBool {
+        return send_all({message});
+    }
+
+    // Several messages in one write
+    qfunc send_all(const std::vector<QubistDict>& messages) -> QubistBool {
+        std::string lines;
+        for(const auto& message : messages) lines += json::dump(message) + "\n";
+        for(size_t sent = 0; sent < lines.size();) {
+            ssize_t n = ::send(fd, lines.data() + sent, lines.size() - sent, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            sent += size_t(n);
+        }
+        return true;
+    }
+
+    // One read; false once the peer is gone or floods us with an endless line
+    qfunc receive() -> QubistBool {
+        char buffer[4096];
+        ssize_t n;
+        do {
+            n = ::recv(fd, buffer, sizeof(buffer), 0);
+        } while(n < 0 && errno == EINTR);
+        if(n <= 0) return false;
+        inbox.append(buffer, size_t(n));
+        return inbox.size() <= max_line;
+    }
+
+    qfunc next(QubistDict& message) -> QubistBool {
+        size_t newline = inbox.find('\n');
+        if(newline == std::string::npos) return false;
+        std::string line = inbox.substr(0, newline);
+        inbox.erase(0, newline + 1);
+        message = json::parse(line);
+        return true;
+    }
+};
+
+} // namespace Stratum
+
+class MiningPool {
+private:
+    struct Range {
+        uint32_t time;
+        uint64_t begin, end;
+    };
+
+    struct Client {
+        std::unique_ptr<Stratum::Connection> link;
+        QubistInt id = 0;
+        QubistInt shares = 0;
+        QubistInt blocks = 0;
+        QubistInt job = 0;              // job the ranges below belong to
+        std::vector<Range> ranges;      // nonce ranges handed to this client
+        QubistBool authorized = false;  // proved the secret
+    };
+
+    QuantumMiner& miner;
+    QubistString secret;
+    uint64_t range_size;
+    QubistFloat share_factor;
+
+    BlockTemplate tmpl;
+    QuantumTarget block_target;
+    QuantumTarget share_target;
+    QubistInt job_id = 0;
+    uint32_t base_time = 0;         // header time when the job opened
+    uint64_t next_nonce = 0;        // first unassigned nonce at tmpl.header.time
+    std::unordered_set<uint64_t> seen_shares;
+    std::chrono::steady_clock::time_point job_started;
+
+    std::map<int, Client> clients;
+    QubistInt next_client = 1;
+    QubistInt blocks_found = 0;
+
+    qfunc new_job() -> void {
+        tmpl = miner.open_template();
+        block_target = QuantumTarget::from_compact(tmpl.header.bits);
+        share_target = block_target.scaled(share_factor);
+        job_id++;
+        base_time = tmpl.header.time;
+        next_nonce = 0;
+        seen_shares.clear();
+        job_started = Simulation::now();
+    }
+
+    // The current job with the next unassigned nonce range, recorded for `client`
+    qfunc assign_work(Client& client) -> QubistDict {
+        if(next_nonce >= (uint64_t(1) << 32)) {
+            tmpl.header.time++;
+            next_nonce = 0;
+        }
+        if(client.job != job_id) {
+            client.job = job_id;
+            client.ranges.clear();
+        }
+        client.ranges.push_back({tmpl.header.time, next_nonce, next_nonce + range_size});
+        QubistDict work = {
+            {"method", "job"},
+            {"job_id", job_id},
+            {"height", tmpl.height},
+            {"header", QuantumMiner::format_quantum_hash(tmpl.header.bytes(), sizeof(QuantumBlockHeader))},
+            {"nonce_begin", QubistInt(next_nonce)},
+            {"nonce_end", QubistInt(next_nonce + range_size)},
+            {"bits", QubistInt(block_target.bits())},
+            {"share_bits", QubistInt(share_target.bits())},
+            {"chain_hash", miner.hash_policy()}
+        };
+        next_nonce += range_size;
+        return work;
+    }
+
+    // "share", "block", "stale", "duplicate" or "invalid"
+    qfunc check_submission(Client& client, QubistDict& message) -> QubistString {
+        if(QubistInt(message["job_id"]) != job_id) return "stale";
+        auto time = uint32_t(QubistInt(message["time"]));
+        auto nonce = uint32_t(QubistInt(message["nonce"]));
+        if(time < base_time || time > tmpl.header.time) return "invalid";
+        // Only nonces from a range this client was given count as its shares
+        if(client.job != job_id ||
+           std::none_of(client.ranges.begin(), client.ranges.end(), [&](const Range& r) {
+               return r.time == time && r.begin <= nonce && nonce < r.end;
+           })) return "invalid";
+
+        QuantumBlockHeader header = tmpl.header;
+        header.time = time;
+        header.nonce = nonce;
+        Hash256 digest = miner.hash_header(header);
+        if(!share_target.met_by(digest.data())) return "invalid";
+        if(!seen_shares.insert((uint64_t(time) << 32) | nonce).second) return "duplicate";
+        if(!block_target.met_by(digest.data())) return "share";
+
+        tmpl.header = header;
+        miner.accept_block(tmpl, std::chrono::duration<double>(Simulation::now() - job_started).count());
+        return "block";
+    }
+
+    qfunc handle(Client& client, QubistDict& message) -> void {
+        if(!client.authorized) {
+            if(!message.count("secret") || !Stratum::same_secret(QubistString(message["secret"]), secret)) {
+                client.link->send(QubistDict{{"method", "error"}, {"reason", "not authorized"}});
+                throw std::runtime_error("not authorized");
+            }
+            client.authorized = true;
+        }
+        QubistString method = message["method"];
+        if(method == "subscribe" || method == "get_work") {
+            client.link->send(assign_work(client));
+            return;
+        }
+        if(method == "transaction") {
+            QubistDict reply = {{"method", "result"}};
+            try {
+                TxId id = miner.submit_transaction(QuantumMiner::transaction_from_json(message));
+                reply["status"] = "accepted";
+                reply["id"] = id.to_hex();
+            } catch(const std::invalid_argument& e) {
+                reply["status"] = "rejected";
+                reply["reason"] = QubistString(e.what());
+            }
+            client.link->send(reply);
+            return;
+        }
+        if(method == "block") {
+            // A block mined by another node; a new tip makes the current job stale
+            QubistString status = miner.import_block(json::dump(QubistDict(message["block"])));
+            client.link->send(QubistDict{{"method", "result"}, {"status", status}});
+            if(status != "tip") return;
+            miner.release_template(tmpl);
+            new_job();
+            for(auto& [fd, other] : clients) other.link->send(assign_work(other));
+            return;
+        }
+        if(method != "submit") {
+            client.link->send(QubistDict{{"method", "error"}, {"reason", "unknown method " + method}});
+            return;
+        }
+
+        QubistString status = check_submission(client, message);
+        if(status == "share" || status == "block") client.shares++;
+        client.link->send(QubistDict{{"method", "result"}, {"status", status}, {"job_id", message["job_id"]}});
+        if(status != "block") return;
+
+        client.blocks++;
+        blocks_found++;
+        std::cout << "🏊 Pool: block from worker " << client.id << " (" << client.shares << " shares, "
+                  << client.blocks << " blocks) | " << clients.size() << " workers connected" << std::endl;
+        new_job();
+        for(auto& [fd, other] : clients) other.link->send(assign_work(other));
+    }
+
+public:
+    qfunc MiningPool(QuantumMiner& chain_miner, QubistString shared_secret, unsigned range_bits = 24,
+                     QubistFloat shares_easier_by = 256.0)
+        : miner(chain_miner), secret(std::move(shared_secret)), range_size(uint64_t(1) << std::clamp(range_bits, 16u, 32u)),
+          share_factor(std::max(1.0, shares_easier_by)) {}
+
+    // Serves until `blocks_to_mine` blocks are appended (0: until killed)
+    qfunc serve(const Stratum::Endpoint& endpoint, QubistInt blocks_to_mine = 0) -> void {
+        int listener = Stratum::open_socket(endpoint, true);
+        new_job();
+        std::cout << "🏊 Pool listening on " << endpoint.describe() << " | block #" << tmpl.height
+                  << " | nonce range 2^" << std::countr_zero(range_size) << std::endl;
+
+        while(blocks_to_mine == 0 || blocks_found < blocks_to_mine) {
+            std::vector<pollfd> fds = {{listener, POLLIN, 0}};
+            for(auto& [fd, client] : clients) fds.push_back({fd, POLLIN, 0});
+            if(::poll(fds.data(), fds.size(), 1000) < 0) {
+                if(errno == EINTR) continue;
+                break;
+            }
+
+            if(fds[0].revents & POLLIN) {
+                int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+                if(fd >= 0) {
+                    Client& client = clients[fd];
+                    client.link = std::make_unique<Stratum::Connection>(fd);
+                    client.id = next_client++;
+                    std::cout << "🔌 Worker " << client.id << " connected" << std::endl;
+                }
+            }
+
+            for(size_t i = 1; i < fds.size(); i++) {
+                if(!fds[i].revents) continue;
+                auto it = clients.find(fds[i].fd);
+                Client& client = it->second;
+                bool alive = client.link->receive();
+                try {
+                    QubistDict message;
+                    while(client.link->next(message)) handle(client, message);
+                } catch(const std::exception& e) {
+                    std::cout << "[!] Worker " << client.id << ": " << e.what() << std::endl;
+                    alive = false;
+                }
+                if(!alive) {
+                    std::cout << "🔌 Worker " << client.id << " disconnected" << std::endl;
+                    clients.erase(it);
+                }
+            }
+        }
+
+        miner.release_template(tmpl);
+        clients.clear();
+        ::close(listener);
+        if(endpoint.unix_socket) ::unlink(endpoint.path.c_str());
+    }
+};
+
+class PoolWorker {
+private:
+    Stratum::Connection link;
+    QubistString secret;
+    unsigned threads;
+    HashKernels::Kernel kernel;
+
+    std::mutex job_mutex;
+    std::condition_variable job_ready;
+    QubistDict job;
+    std::atomic<uint64_t> generation{0};
+    QubistBool closed = false;
+    NonceSearch::Throttle throttle;     // cancelled when newer work arrives
+
+    std::atomic<uint64_t> hashes{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> rejected{0};
+
+    // Hashing threads only queue their messages; the sender thread writes
+    // whatever has queued up in one send, so a burst of shares costs one
+    // syscall and no hashing thread waits on the socket
+    MpscQueue<QubistDict> outbox;
+    std::atomic<uint64_t> outbox_signal{0};     // bumped on every queued message and on shutdown
+    std::atomic<bool> outbox_closed{false};
+
+    qfunc send(QubistDict message) -> void {
+        outbox.push(std::move(message));
+        outbox_signal.fetch_add(1, std::memory_order_release);
+        outbox_signal.notify_one();
+    }
+
+    qfunc send_loop() -> void {
+        std::vector<QubistDict> batch;
+        while(true) {
+            uint64_t seen = outbox_signal.load(std::memory_order_acquire);
+            batch.clear();
+            QubistDict message;
+            while(outbox.pop(message)) batch.push_back(std::move(message));
+            if(!batch.empty()) {
+                link.send_all(batch);     // a closed link is noticed by read_loop
+                continue;
+            }
+            if(outbox_closed.load(std::memory_order_acquire)) break;
+            outbox_signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    qfunc read_loop() -> void {
+        try {
+            while(link.receive()) {
+                QubistDict message;
+                while(link.next(message)) {
+                    QubistString method = message["method"];
+                    if(method == "job") {
+                        std::lock_guard<std::mutex> lock(job_mutex);
+                        job = message;
+                        generation.fetch_add(1, std::memory_order_release);
+                        throttle.cancelled.store(true, std::memory_order_relaxed);
+                        job_ready.notify_one();
+                    } else if(method == "result") {
+                        QubistString status = message["status"];
+                        if(status == "share" || status == "block") accepted++;
+                        else rejected++;
+                        if(status == "block") std::cout << "⛏️  Block accepted by pool" << std::endl;
+                    } else if(method == "error") {
+                        std::cout << "❌ Pool: " << message["reason"] << std::endl;
+                    }
+                }
+            }
+        } catch(const std::exception& e) {
+            std::cout << "[!] Pool message: " << e.what() << std::endl;
+        }
+        std::lock_guard<std::mutex> lock(job_mutex);
+        closed = true;
+        throttle.cancelled.store(true, std::memory_order_relaxed);
+        job_ready.notify_one();
+    }
+
+    // Sweeps the job's nonce range; true if newer work arrived first
+    qfunc search(QubistDict& work, uint64_t seen) -> QubistBool {
+        QubistString chain_hash = work.count("chain_hash") ? QubistString(work["chain_hash"]) : "sha256";
+        with_hash_policy(chain_hash, [&]<typename Hash>() { search_range<Hash>(work); });
+        return generation.load(std::memory_order_acquire) != seen;
+    }
+
+    template <typename Hash>
+    qfunc search_range(QubistDict& work) -> void {
+        QuantumBlockHeader header;
+        QuantumMiner::parse_quantum_hash(work["header"], reinterpret_cast<unsigned char*>(&header),
+                                         sizeof(QuantumBlockHeader));
+        auto begin = uint64_t(QubistInt(work["nonce_begin"]));
+        auto end = uint64_t(QubistInt(work["nonce_end"]));
+        QubistInt job_id = work["job_id"];
+        QuantumTarget block = QuantumTarget::from_compact(uint32_t(QubistInt(work["bits"])));
+        QuantumTarget share = QuantumTarget::from_compact(uint32_t(QubistInt(work["share_bits"])));
+        QuantumMidstate midstate(header);
+        std::vector<Telemetry::Counter> hashed(std::min(threads, Telemetry::max_threads));
+
+        NonceSearch::run_batched([&](QubistInt offset) {
+            auto first = uint32_t(begin + uint64_t(offset));
+            unsigned char digests[16 * 32];
+            if constexpr(Hash::uses_midstate) {
+                HashKernels::hash_batch(kernel, midstate, first, digests);
+                for(unsigned l = 0; l < kernel.lanes; l++) Hash::finish(digests + 32 * l);
+            } else {
+                QuantumBlockHeader attempt = header;
+                for(unsigned l = 0; l < kernel.lanes; l++) {
+                    attempt.nonce = first + l;
+                    Hash::hash(attempt, digests + 32 * l);
+                }
+            }
+            for(unsigned l = 0; l < kernel.lanes; l++) {
+                if(!share.met_by(digests + 32 * l)) continue;
+                send(QubistDict{{"method", "submit"}, {"job_id", job_id},
+                                {"time", QubistInt(header.time)}, {"nonce", QubistInt(first + l)}});
+                if(block.met_by(digests + 32 * l)) return offset + l;
+            }
+            return NonceSearch::not_found;
+        }, threads, kernel.lanes, QubistInt(end - begin), hashed.data(), &throttle);
+
+        for(auto& counter : hashed) hashes.fetch_add(counter.value.load(), std::memory_order_relaxed);
     }
 
 public:
-    qfunc mine_block(QubistInt difficulty = 4) -> QubistDict {
-        current_height++;
-       
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::system_clock::to_time_t(now);
-       
-        // Generate quantum-secure keypair for block
-        EC_KEY* key = EC_KEY_new_by_curve_name(NID_secp256k1);
-        EC_KEY_generate_key(key);
-       
-        // Mine block with quantum-resistant algorithm
-        QubistInt nonce = 0;
-        QubistString block_hash;
-        auto start = std::chrono::high_resolution_clock::now();
-       
+    qfunc PoolWorker(const Stratum::Endpoint& endpoint, QubistString shared_secret, unsigned hashing_threads,
+                     const HashKernels::Kernel& hash_kernel)
+        : link(Stratum::open_socket(endpoint, false)), secret(std::move(shared_secret)),
+          threads(std::max(1u, hashing_threads)), kernel(hash_kernel) {}
+
+    qfunc run() -> void {
+        std::cout << "👷 Worker: " << threads << " threads, " << kernel.name << " kernel" << std::endl;
+        std::cout << "🧭 Placement: " << Placement::describe() << std::endl;
+        std::thread reader([this]() {
+            Placement::pin_io();
+            read_loop();
+        });
+        std::thread sender([this]() {
+            Placement::pin_io();
+            send_loop();
+        });
+        send(QubistDict{{"method", "subscribe"}, {"secret", secret}});
+
+        auto start = Simulation::now();
+        uint64_t seen = 0;
         while(true) {
-            block_hash = generate_quantum_hash(std::to_string(current_height) +
-                                              std::to_string(timestamp), nonce);
-           
-            if(block_hash.substr(0, difficulty) == std::string(difficulty, '0')) {
-                break;
+            QubistDict work;
+            {
+                std::unique_lock<std::mutex> lock(job_mutex);
+                job_ready.wait(lock, [&]() { return closed || generation.load() != seen; });
+                if(closed) break;
+                work = job;
+                seen = generation.load();
+                throttle.cancelled.store(false, std::memory_order_relaxed);
             }
-            nonce++;
-        }
-       
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration<double>(end - start).count();
-       
-        // Create block
-        QubistDict block = {
-            {"height", current_height},
-            {"hash", block_hash},
-            {"previous_hash", current_height > 1 ? "0000..." : "0"},
-            {"timestamp", timestamp},
-            {"nonce", nonce},
-            {"difficulty", difficulty},
-            {"mining_time", duration},
-            {"reward", block_reward},
-            {"miner_address", "quantum_miner_" +
-                std::to_string(std::hash<std::string>{}(block_hash.substr(0, 16)))},
-            {"quantum_state", "superposition|mined⟩"}
-        };
-       
-        // Save to chain
-        std::ofstream chain(chain_file, std::ios::app);
-        chain << json::dump(block) << std::endl;
-       
-        std::cout << "⛏️  Quantum block #" << current_height << " mined" << std::endl;
-        std::cout << "   Hash: " << block_hash.substr(0, 32) << "..." << std::endl;
-        std::cout << "   Nonce: " << nonce << " | Time: " << duration << "s" << std::endl;
-        std::cout << "   Reward: " << block_reward << " mirror BTC" << std::endl;
-       
-        EC_KEY_free(key);
-        return block;
-    }
-   
-    qfunc continuous_mining(QubistInt blocks_to_mine = 10) -> void {
-        std::cout << "🚀 Starting continuous quantum mining..." << std::endl;
-       
-        for(QubistInt i = 0; i < blocks_to_mine; i++) {
-            mine_block();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if(!search(work, seen)) send(QubistDict{{"method", "get_work"}, {"job_id", work["job_id"]}});
         }
+        reader.join();
+        outbox_closed.store(true, std::memory_order_release);
+        outbox_signal.fetch_add(1, std::memory_order_release);
+        outbox_signal.notify_one();
+        sender.join();
+
+        auto elapsed = std::chrono::duration<double>(Simulation::now() - start).count();
+        std::cout << "👷 Pool closed: " << accepted.load() << " shares accepted, " << rejected.load()
+                  << " rejected | ~" << (elapsed > 0 ? hashes.load() / elapsed / 1e6 : 0.0) << " MH/s" << std::endl;
     }
 };
 
@@ -285,6 +5160,7 @@ class QuantumAICycle {
 private:
     QubistString ideas_file = "agents_ideas.jsonl";
     QubistString outputs_file = "agents_outputs.jsonl";
+    std::mt19937_64 rng = Simulation::engine("ai_cycle");
    
     qfunc quantum_ai_analysis(QubistDict idea_entry) -> QubistString {
         // Quantum neural network simulation
@@ -302,10 +5178,10 @@ private:
         analysis << "|idea⟩ = α|implementable⟩ + β|abstract⟩" << std::endl;
         analysis << std::endl;
         analysis << "Quantum viability measurement:" << std::endl;
-        analysis << "⟨viabilidad|idea⟩ = " << (std::rand() % 100) / 100.0 << std::endl;
+        analysis << "⟨viabilidad|idea⟩ = " << (rng() % 100) / 100.0 << std::endl;
         analysis << std::endl;
         analysis << "Entanglement with mirror blockchain: ✓" << std::endl;
-        analysis << "Quantum coherence maintained: " << (std::rand() % 50 + 50) << "%" << std::endl;
+        analysis << "Quantum coherence maintained: " << (rng() % 50 + 50) << "%" << std::endl;
        
         return analysis.str();
     }
@@ -323,13 +5199,13 @@ public:
             auto analysis = quantum_ai_analysis(idea);
            
             QubistDict output = {
-                {"timestamp", std::time(nullptr)},
+                {"timestamp", Simulation::unix_time()},
                 {"agent_id", idea["agent_id"]},
                 {"agent_name", idea["agent_name"]},
                 {"original_idea", idea["idea"]},
                 {"quantum_analysis", analysis},
             {"quantum_state", "|analyzed⟩"},
-                {"decoherence_factor", (std::rand() % 30) / 100.0}
+                {"decoherence_factor", (rng() % 30) / 100.0}
             };
            
             std::ofstream outputs(outputs_file, std::ios::app);
@@ -345,30 +5221,107 @@ public:
 };
 
 // ==================== QUANTUM ENERGY SENSOR ====================
+// Cumulative energy in joules. Real readings come from the RAPL package
+// counters under /sys/class/powercap when the kernel exposes them.
+// Otherwise a model stands in: idle draw plus a per-core share for the
+// busy cores the caller reports, with a little vacuum-fluctuation noise.
+class EnergyMeter {
+private:
+    struct Zone {
+        QubistString path;
+        uint64_t range = 0;       // counter wraps here
+        uint64_t last = 0;
+    };
+    std::vector<Zone> zones;
+    QubistFloat total = 0.0;
+    std::chrono::steady_clock::time_point last_read = Simulation::now();
+    std::mt19937_64 rng = Simulation::engine("energy_meter");
+
+    static qfunc read_counter(const QubistString& path) -> uint64_t {
+        std::ifstream in(path);
+        uint64_t value = 0;
+        in >> value;
+        return value;
+    }
+
+public:
+    static constexpr QubistFloat idle_watts = 12.0;
+    static constexpr QubistFloat core_watts = 6.0;
+
+    // Seeded runs always use the model: real counters would make them irreproducible
+    qfunc EnergyMeter() {
+        if(Simulation::enabled()) return;
+        // Top-level package domains only (intel-rapl:N); subzones are counted inside them
+        std::error_code error;
+        for(const auto& entry : std::filesystem::directory_iterator("/sys/class/powercap", error)) {
+            QubistString name = entry.path().filename();
+            if(name.rfind("intel-rapl:", 0) != 0 || name.find(':', 11) != QubistString::npos) continue;
+            Zone zone;
+            zone.path = (entry.path() / "energy_uj").string();
+            zone.range = read_counter((entry.path() / "max_energy_range_uj").string());
+            std::ifstream probe(zone.path);
+            if(!probe || !(probe >> zone.last)) continue;      // unreadable without privileges
+            zones.push_back(zone);
+        }
+    }
+
+    qfunc source() const -> QubistString { return zones.empty() ? "model" : "rapl"; }
+
+    // Model draw: idle plus `busy_cores` cores, with jitter
+    qfunc model_watts(QubistFloat busy_cores) -> QubistFloat {
+        std::normal_distribution<> noise(1.0, 0.03);
+        return (idle_watts + core_watts * busy_cores) * std::max(0.0, noise(rng));
+    }
+
+    // Model only: books `seconds` of draw, for callers keeping their own
+    // (virtual) time; returns the total like joules()
+    qfunc advance(QubistFloat seconds, QubistFloat busy_cores) -> QubistFloat {
+        total += model_watts(busy_cores) * seconds;
+        return total;
+    }
+
+    // Joules since construction; `busy_cores` only feeds the model
+    qfunc joules(QubistFloat busy_cores = 0.0) -> QubistFloat {
+        auto now = Simulation::now();
+        QubistFloat seconds = std::chrono::duration<QubistFloat>(now - last_read).count();
+        last_read = now;
+        if(zones.empty()) return advance(seconds, busy_cores);
+        for(Zone& zone : zones) {
+            uint64_t value = read_counter(zone.path);
+            uint64_t delta = value >= zone.last ? value - zone.last : zone.range - zone.last + value;
+            zone.last = value;
+            total += delta / 1e6;
+        }
+        return total;
+    }
+};
+
 class QuantumEnergySensor {
 private:
+    std::mt19937_64 rng = Simulation::engine("energy_sensor");
+
     qfunc measure_quantum_fluctuations() -> QubistFloat {
         // Simulate quantum energy measurements
-        std::random_device rd;
-        std::mt19937 gen(rd());
         std::normal_distribution<> d(1.0, 0.5);
        
-        return std::abs(d(gen));
+        return std::abs(d(rng));
     }
    
     qfunc quantum_entanglement_score() -> QubistFloat {
-        return (std::rand() % 100) / 100.0;
+        return (rng() % 100) / 100.0;
     }
 
 public:
     qfunc monitor(QubistInt interval_seconds = 5) -> void {
         std::cout << "🔋 Starting quantum energy sensor..." << std::endl;
         std::cout << "   Mode: Vacuum fluctuation measurement" << std::endl;
+        EnergyMeter meter;
+        QubistFloat last_joules = meter.joules();
        
         while(true) {
             auto energy = measure_quantum_fluctuations();
             auto entanglement = quantum_entanglement_score();
-            auto timestamp = std::time(nullptr);
+            auto timestamp = Simulation::unix_time();
            
             QubistDict measurement = {
                 {"timestamp", timestamp},
@@ -376,18 +5329,165 @@ public:
                 {"entanglement_score", entanglement},
                 {"zero_point_fluctuation", energy * 0.5},
                 {"quantum_state", "|measuring⟩"},
-                {"observer_effect", (std::rand() % 20) / 100.0}
+                {"observer_effect", (rng() % 20) / 100.0}
             };
            
             std::cout << "⏰ " << std::ctime(&timestamp);
             std::cout << "   Quantum energy: " << energy << " QE" << std::endl;
             std::cout << "   Entanglement: " << (entanglement * 100) << "%" << std::endl;
             std::cout << "   Zero-point fluctuation: " << measurement["zero_point_fluctuation"] << std::endl;
+            if(meter.source() == "rapl") {
+                QubistFloat joules = meter.joules();
+                std::cout << "   Package power: " << (joules - last_joules) / interval_seconds << " W" << std::endl;
+                last_joules = joules;
+            }
             std::cout << std::string(40, '-') << std::endl;
            
-            std::this_thread::sleep_for(std::chrono::seconds(interval_seconds));
+            Simulation::sleep(std::chrono::seconds(interval_seconds));
+        }
+    }
+};
+
+// ==================== ENERGY GOVERNOR ====================
+// Keeps the miner under a power budget (watts) and/or an energy budget
+// (joules for the whole run). Once a period it measures power over the last
+// window and scales hashing capacity (active threads x duty) toward 95% of
+// the budget. Whole threads are parked first, so idle cores can drop into
+// deep C-states, and only the last partial thread is duty-cycled. Once the
+// energy budget is spent the miner stops after its current block. Either
+// way the governor reports hashes per joule. Seeded runs have no sampling
+// thread: the miner calls step() after each block, and the period is the
+// virtual time its hashes took, so they stop after the same block every run.
+class EnergyGovernor {
+private:
+    QuantumMiner& miner;
+    NonceSearch::Throttle& throttle;
+    EnergyMeter meter;
+    QubistFloat power_budget;
+    QubistFloat energy_budget;
+    std::chrono::milliseconds period;
+    QubistFloat capacity;                 // busy-thread equivalents
+    QubistFloat spent = 0.0;
+    QubistFloat last_power = 0.0;
+    uint64_t hashes_at_start = 0;
+    uint64_t hashes_at_step = 0;          // seeded runs
+    QubistFloat virtual_seconds = 0.0;    // seeded runs
+    std::chrono::steady_clock::time_point started = Simulation::now();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+    static constexpr QubistFloat headroom = 0.95;
+    static constexpr QubistFloat min_capacity = 0.05;
+    static constexpr QubistInt report_every = 10;
+    QubistInt periods = 0;
+
+    qfunc apply(QubistFloat wanted) -> void {
+        capacity = std::clamp(wanted, min_capacity, QubistFloat(miner.thread_count()));
+        unsigned active = std::max(1u, unsigned(std::ceil(capacity - 1e-9)));
+        throttle.active.store(active, std::memory_order_relaxed);
+        throttle.duty.store(capacity / active, std::memory_order_relaxed);
+    }
+
+    // One period: `joules` is the meter total, `seconds` the span since the last
+    qfunc sample(QubistFloat joules, QubistFloat seconds) -> void {
+        last_power = seconds > 0 ? (joules - spent) / seconds : 0.0;
+        spent = joules;
+
+        if(power_budget > 0 && last_power > 0) {
+            // Damped proportional step: power is idle draw plus a per-core
+            // share, so a full-ratio jump would overshoot
+            apply(capacity * (1.0 + 0.5 * (headroom * power_budget / last_power - 1.0)));
+        }
+        if(energy_budget > 0 && spent >= energy_budget) throttle.halted.store(true, std::memory_order_relaxed);
+
+        if(++periods % report_every == 0) {
+            QubistDict r = report();
+            std::cout << "⚡ " << r["power_w"] << " W";
+            if(power_budget > 0) std::cout << " / " << power_budget << " W budget";
+            std::cout << " | " << r["active_threads"] << " threads @ " << r["duty"] << " duty | "
+                      << QubistFloat(r["hashes_per_joule"]) / 1e3 << " kH/J" << std::endl;
+        }
+    }
+
+    qfunc run() -> void {
+        Placement::pin_io();
+        spent = meter.joules(capacity);
+        auto last = Simulation::now();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!wake.wait_for(lock, period, [this]() { return stopping; })) {
+            auto now = Simulation::now();
+            sample(meter.joules(capacity), std::chrono::duration<QubistFloat>(now - last).count());
+            last = now;
         }
     }
+
+public:
+    qfunc EnergyGovernor(QuantumMiner& governed, QubistFloat watts, QubistFloat joules,
+                         std::chrono::milliseconds sample_period = std::chrono::milliseconds(1000))
+        : miner(governed), throttle(governed.search_throttle()), power_budget(watts), energy_budget(joules),
+          period(sample_period), capacity(governed.thread_count()) {
+        hashes_at_start = hashes_at_step = miner.hashes_done();
+        apply(capacity);
+        throttle.halted.store(false, std::memory_order_relaxed);
+        if(meter.source() == "model") {
+            std::cout << "[!] No readable RAPL counters" << (Simulation::enabled() ? " in a seeded run" : "")
+                      << ": budget enforced against the power model (" << EnergyMeter::idle_watts << " W + "
+                      << EnergyMeter::core_watts << " W per busy thread), not measured draw" << std::endl;
+        }
+        if(Simulation::enabled()) miner.set_block_hook([this]() { step(); });
+        else worker = std::thread([this]() { run(); });
+    }
+
+    // Seeded runs: one period per block, as long as its hashes took at the
+    // virtual hash rate
+    qfunc step() -> void {
+        uint64_t hashes = miner.hashes_done();
+        QubistFloat seconds = (hashes - hashes_at_step) / Simulation::hash_rate;
+        hashes_at_step = hashes;
+        virtual_seconds += seconds;
+        sample(meter.advance(seconds, capacity), seconds);
+    }
+
+    // Hands the miner back at full capacity and prints the run's summary
+    qfunc ~EnergyGovernor() {
+        if(worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+            spent = meter.joules(capacity);
+        } else {
+            miner.set_block_hook(nullptr);
+        }
+        apply(miner.thread_count());
+
+        QubistDict r = report();
+        std::cout << "⚡ Energy: " << r["joules"] << " J (" << r["source"] << ") for " << r["hashes"]
+                  << " hashes | " << QubistFloat(r["hashes_per_joule"]) / 1e3 << " kH/J, avg "
+                  << r["avg_power_w"] << " W" << std::endl;
+    }
+
+    qfunc report() -> QubistDict {
+        uint64_t hashes = miner.hashes_done() - hashes_at_start;
+        QubistFloat seconds = Simulation::enabled() ? virtual_seconds
+                                                    : std::chrono::duration<QubistFloat>(Simulation::now() - started).count();
+        return QubistDict{
+            {"source", meter.source()},
+            {"power_w", last_power},
+            {"avg_power_w", seconds > 0 ? spent / seconds : 0.0},
+            {"joules", spent},
+            {"hashes", QubistInt(hashes)},
+            {"hashes_per_joule", spent > 0 ? hashes / spent : 0.0},
+            {"active_threads", QubistInt(throttle.active.load())},
+            {"duty", throttle.duty.load()}
+        };
+    }
 };
 
 // ==================== MAIN QUANTUM ORCHESTRATOR ====================
@@ -398,8 +5498,182 @@ private:
     QuantumAICycle ai_engine;
     QuantumEnergySensor energy_sensor;
    
+    // Pulls "--name value" / "--name=value" out of args, leaving positionals in place
+    qfunc take_option(QubistList& args, QubistString name, QubistString fallback = "") -> QubistString {
+        QubistString flag = "--" + name;
+        for(size_t i = 0; i < args.size(); i++) {
+            QubistString arg = args[i];
+            if(arg == flag && i + 1 < args.size()) {
+                QubistString value = args[i + 1];
+                args.erase(args.begin() + i, args.begin() + i + 2);
+                return value;
+            }
+            if(arg.rfind(flag + "=", 0) == 0) {
+                args.erase(args.begin() + i);
+                return arg.substr(flag.size() + 1);
+            }
+        }
+        return fallback;
+    }
+
+    // Pulls a bare "--name" switch out of args
+    qfunc take_flag(QubistList& args, QubistString name) -> QubistBool {
+        QubistString flag = "--" + name;
+        for(size_t i = 0; i < args.size(); i++) {
+            if(QubistString(args[i]) == flag) {
+                args.erase(args.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // --threads N: positive, capped at a few threads per core (`fallback` when absent)
+    qfunc take_threads(QubistList& args, unsigned fallback) -> unsigned {
+        QubistString value = take_option(args, "threads");
+        if(value.empty()) return fallback;
+        long long requested = std::stoll(value);
+        if(requested <= 0) throw std::invalid_argument("--threads must be positive, got " + value);
+        unsigned limit = 4 * std::max(1u, std::thread::hardware_concurrency());
+        if(requested > limit) {
+            std::cout << "⚠️  --threads " << requested << " capped at " << limit << std::endl;
+            return limit;
+        }
+        return unsigned(requested);
+    }
+
+    // --power-budget W / --energy-budget J attach a governor for the caller's scope
+    qfunc take_governor(QubistList& args) -> std::unique_ptr<EnergyGovernor> {
+        QubistFloat watts = std::stod(take_option(args, "power-budget", "0"));
+        QubistFloat joules = std::stod(take_option(args, "energy-budget", "0"));
+        if(watts <= 0 && joules <= 0) return nullptr;
+        return std::make_unique<EnergyGovernor>(miner, watts, joules);
+    }
+
+    // --secret S, else the environment; the pool and its clients refuse to run without one
+    qfunc take_secret(QubistList& args) -> QubistString {
+        const char* from_env = std::getenv(Stratum::secret_variable);
+        QubistString secret = take_option(args, "secret", from_env ? from_env : "");
+        if(secret.empty()) {
+            throw std::invalid_argument(QubistString("pool needs a shared secret: --secret S or ") +
+                                        Stratum::secret_variable);
+        }
+        return secret;
+    }
+
+    // Sends one transaction to a running pool and reports its verdict
+    qfunc submit_to_pool(const Stratum::Endpoint& endpoint, const QubistString& secret, QubistDict transaction) -> void {
+        Stratum::Connection link(Stratum::open_socket(endpoint, false));
+        transaction["method"] = "transaction";
+        transaction["secret"] = secret;
+       
+        QubistDict reply;
+        if(!link.send(transaction)) throw std::runtime_error("pool closed the connection");
+        while(!link.next(reply)) {
+            if(!link.receive()) throw std::runtime_error("pool closed the connection");
+        }
+        if(reply["status"] == "accepted") {
+            std::cout << "📨 Transaction " << reply["id"] << " queued in the pool mempool" << std::endl;
+        } else {
+            std::cout << "❌ Transaction rejected: " << reply["reason"] << std::endl;
+        }
+    }
+   
+    // Queues a JSONL file of transactions (the fields of a pool
+    // "transaction" message, one per line) in the local mempool
+    qfunc queue_transactions(const QubistString& file) -> void {
+        std::ifstream in(file);
+        if(!in) throw std::runtime_error("cannot open " + file);
+        QubistInt queued = 0;
+        QubistInt rejected = 0;
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.empty()) continue;
+            try {
+                QubistDict entry = json::parse(line);
+                miner.submit_transaction(QuantumMiner::transaction_from_json(entry));
+                queued++;
+            } catch(const std::invalid_argument& e) {
+                rejected++;
+                std::cout << "❌ Transaction rejected: " << e.what() << std::endl;
+            }
+        }
+        std::cout << "📨 " << queued << " transactions from " << file << " queued in the mempool";
+        if(rejected) std::cout << " (" << rejected << " rejected)";
+        std::cout << std::endl;
+    }
+
+    // Feeds another node's JSONL chain, record by record, to the local chain
+    // or to a running pool (`connect` non-empty)
+    qfunc import_blocks(const QubistString& file, const QubistString& connect, const QubistString& secret) -> void {
+        std::ifstream in(file);
+        if(!in) throw std::runtime_error("cannot open " + file);
+        std::unique_ptr<Stratum::Connection> link;
+        if(!connect.empty()) {
+            link = std::make_unique<Stratum::Connection>(Stratum::open_socket(Stratum::Endpoint::parse(connect), false));
+        }
+       
+        std::map<QubistString, QubistInt> outcomes;
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.empty()) continue;
+            if(!link) {
+                outcomes[miner.import_block(line)]++;
+                continue;
+            }
+            QubistDict reply;
+            QubistDict message = {{"method", "block"}, {"block", QubistDict(json::parse(line))}, {"secret", secret}};
+            if(!link->send(message)) {
+                throw std::runtime_error("pool closed the connection");
+            }
+            do {        // skip the job broadcasts a new tip triggers
+                while(!link->next(reply)) {
+                    if(!link->receive()) throw std::runtime_error("pool closed the connection");
+                }
+            } while(QubistString(reply["method"]) != "result");
+            outcomes[QubistString(reply["status"])]++;
+        }
+       
+        std::cout << "📥 Import of " << file << ":";
+        for(const auto& [status, count] : outcomes) std::cout << " " << count << " " << status;
+        std::cout << std::endl;
+    }
+   
+    // Chain store, durability and target options shared by mine and pool
+    qfunc configure_chain(QubistList& args) -> void {
+        std::cout << "🧭 Placement: " << Placement::describe() << std::endl;
+        miner.set_chain_store(take_option(args, "store", "jsonl"));
+        miner.set_durability(DurabilityPolicy::parse(take_option(args, "durability", "interval"),
+                                                     std::stoll(take_option(args, "sync-blocks", "64")),
+                                                     std::stoll(take_option(args, "sync-ms", "100"))));
+       
+        miner.set_hash_policy(take_option(args, "chain-hash", miner.hash_policy()),
+                              take_option(args, "target-check", "headword"));
+        miner.set_retargeting(take_option(args, "retarget", "on") != "off");
+        QubistString snapshot_every = take_option(args, "snapshot-every");
+        if(!snapshot_every.empty()) miner.set_snapshot_interval(std::stoll(snapshot_every));
+        QubistString bits = take_option(args, "bits");
+        QubistString difficulty = take_option(args, "difficulty");
+        if(!bits.empty()) {
+            miner.set_target(QuantumTarget::from_compact(std::stoul(bits, nullptr, 0)));
+        } else if(!difficulty.empty()) {
+            miner.set_target(QuantumTarget::from_zero_bits(unsigned(std::stod(difficulty) * 4)));
+        }
+    }
+   
 public:
+    qfunc SatoshiMirrorCore() {
+        miner.connect_ledger(ledger);
+    }
+   
     qfunc execute(QubistString mode, QubistList args = {}) -> void {
+        // Modes that book into the ledger take it for writing, and refuse to
+        // start while another process has it; the rest only read it
+        static const std::unordered_set<QubistString> ledger_writers = {
+            "add_agent", "mine", "pool", "import", "restore", "quantum_synthesis"
+        };
+        if(ledger_writers.count(mode)) ledger.open_journal();
+
         if(mode == "add_agent") {
             if(args.size() < 2) {
                 std::cout << "❌ Usage: add_agent <id> <name> [description]" << std::endl;
@@ -411,7 +5685,30 @@ public:
            
             ledger.add_agent(args[0], args[1], desc, meta);
            
+        } else if(mode == "grant" || mode == "transfer") {
+            Stratum::Endpoint endpoint = Stratum::Endpoint::parse(take_option(args, "connect", "tcp:127.0.0.1:3333"));
+            QubistString secret = take_secret(args);
+            QubistFloat fee = std::stod(take_option(args, "fee", "0"));
+            QubistBool grant = mode == "grant";
+            if(args.size() < (grant ? 2u : 3u)) {
+                std::cout << "❌ Usage: grant <agent> <amount> [--connect ENDPOINT] | transfer <from> <to> <amount> [--fee F] [--connect ENDPOINT]" << std::endl;
+                return;
+            }
+            QubistDict tx = {{"kind", mode}, {"fee", fee}};
+            if(!grant) tx["from"] = QubistString(args[0]);
+            tx["to"] = QubistString(args[grant ? 0 : 1]);
+            tx["amount"] = std::stod(QubistString(args[grant ? 1 : 2]));
+            submit_to_pool(endpoint, secret, tx);
+           
         } else if(mode == "mine") {
+            miner.set_mining_threads(take_threads(args, miner.thread_count()));
+            miner.set_hash_path(take_option(args, "hash-path", "midstate"));
+            miner.set_hash_kernel(take_option(args, "hash-kernel", "auto"));
+            configure_chain(args);
+            auto governor = take_governor(args);
+            QubistString transactions = take_option(args, "transactions");
+            if(!transactions.empty()) queue_transactions(transactions);
+           
             QubistInt blocks = args.empty() ? 1 : std::stoi(args[0]);
            
             if(blocks == 1) {
@@ -420,6 +5717,70 @@ public:
                 miner.continuous_mining(blocks);
             }
            
+        } else if(mode == "pool") {
+            Stratum::Endpoint endpoint = Stratum::Endpoint::parse(take_option(args, "listen", "tcp:127.0.0.1:3333"));
+            unsigned range_bits = unsigned(std::stoul(take_option(args, "range-bits", "24")));
+            QubistFloat share_factor = std::stod(take_option(args, "share-factor", "256"));
+            QubistString secret = take_secret(args);
+            configure_chain(args);
+           
+            MiningPool pool(miner, secret, range_bits, share_factor);
+            pool.serve(endpoint, args.empty() ? 0 : std::stoi(args[0]));
+           
+        } else if(mode == "worker") {
+            Stratum::Endpoint endpoint = Stratum::Endpoint::parse(take_option(args, "connect", "tcp:127.0.0.1:3333"));
+            QubistString secret = take_secret(args);
+            PoolWorker worker(endpoint, secret, take_threads(args, Placement::hashing_threads()),
+                              HashKernels::by_name(take_option(args, "hash-kernel", "auto")));
+            worker.run();
+           
+        } else if(mode == "import") {
+            QubistString connect = take_option(args, "connect");
+            QubistString secret = connect.empty() ? "" : take_secret(args);
+            miner.set_chain_store(take_option(args, "store", "jsonl"));
+            if(args.empty()) {
+                std::cout << "❌ Usage: import <chain.jsonl> [--store S] [--connect ENDPOINT]" << std::endl;
+                return;
+            }
+            import_blocks(args[0], connect, secret);
+           
+        } else if(mode == "snapshot") {
+            QubistBool prune = take_flag(args, "prune");
+            miner.set_chain_store(take_option(args, "store", "jsonl"));
+            QubistString path = miner.take_snapshot();
+            if(prune) miner.prune_store(StateSnapshot::load(path).height);
+           
+        } else if(mode == "restore") {
+            miner.set_chain_store(take_option(args, "store", "jsonl"));
+            miner.restore_ledger();
+           
+        } else if(mode == "verify") {
+            miner.set_mining_threads(take_threads(args, miner.thread_count()));
+            miner.set_chain_store(take_option(args, "store", "jsonl"));
+            miner.set_hash_policy(take_option(args, "chain-hash", miner.hash_policy()), "exact");
+            miner.verify_chain();
+           
+        } else if(mode == "export-jsonl") {
+            // The default never lands on the JSONL chain, nor on an earlier export
+            QubistString out_file = args.empty() ? "mirror_chain.export.jsonl" : QubistString(args[0]);
+            if(args.empty() && std::filesystem::exists(out_file)) {
+                throw std::invalid_argument(out_file + " already exists; name the output file to overwrite it");
+            }
+            miner.export_jsonl(out_file);
+           
+        } else if(mode == "stats") {
+            QubistBool as_json = false;
+            for(size_t i = 0; i < args.size(); i++) {
+                if(QubistString(args[i]) == "--json") as_json = true;
+            }
+            auto stats = MiningTelemetry::open(MiningTelemetry::default_path);
+            if(!stats) {
+                std::cout << "❌ No miner stats at " << MiningTelemetry::default_path << std::endl;
+                return;
+            }
+            if(as_json) std::cout << json::dump(stats->to_json()) << std::endl;
+            else stats->print();
+           
         } else if(mode == "ai_cycle") {
             ai_engine.process_ideas();
            
@@ -431,21 +5792,26 @@ public:
             std::cout << "🌀 STARTING FULL QUANTUM SYNTHESIS" << std::endl;
             std::cout << "=======================================" << std::endl;
            
-            // Parallel quantum execution
+            // Parallel quantum execution; the governor couples the energy stream to the miner
+            QubistFloat watts = std::stod(take_option(args, "power-budget", "0"));
+            QubistFloat joules = std::stod(take_option(args, "energy-budget", "0"));
             std::vector<std::thread> threads;
            
-            threads.emplace_back([this]() {
+            threads.emplace_back([this, watts, joules]() {
                 std::cout << "[Thread 1] Quantum mining..." << std::endl;
+                EnergyGovernor governor(miner, watts, joules);
                 miner.continuous_mining(3);
             });
            
             threads.emplace_back([this]() {
                 std::cout << "[Thread 2] Quantum AI cycle..." << std::endl;
+                Placement::pin_io();
                 ai_engine.process_ideas();
             });
            
             threads.emplace_back([this]() {
                 std::cout << "[Thread 3] Energy sensor..." << std::endl;
+                Placement::pin_io();
                 energy_sensor.monitor(3);
             });
            
@@ -464,33 +5830,575 @@ public:
         std::cout << "Quantum commands:" << std::endl;
         std::cout << "  add_agent <id> <name>    - Add agent to the ledger" << std::endl;
         std::cout << "  mine [blocks]             - Mine mirror blocks" << std::endl;
+        std::cout << "    --threads N                 hashing threads (default: all cores)" << std::endl;
+        std::cout << "    --hash-path midstate|full   prefix midstate or whole-buffer SHA256" << std::endl;
+        std::cout << "    --hash-kernel auto|scalar|avx2|avx512|shani" << std::endl;
+        std::cout << "    --chain-hash sha256|sha256d|fast  block hash (default: blockchain.hash_function)" << std::endl;
+        std::cout << "    --target-check headword|exact     hit test in the search loop (default: headword)" << std::endl;
+        std::cout << "    --difficulty D              leading zero hex digits, quarter steps allowed" << std::endl;
+        std::cout << "    --bits 0x1f7fffff           explicit compact target" << std::endl;
+        std::cout << "    --retarget on|off           adjust toward blockchain.target_block_time" << std::endl;
+        std::cout << "    --store jsonl|binary        chain format (binary: segmented data/blocks)" << std::endl;
+        std::cout << "    --durability none|interval|block  chain fsync policy (default: interval)" << std::endl;
+        std::cout << "    --sync-blocks N --sync-ms T       interval policy: fdatasync every N blocks or T ms" << std::endl;
+        std::cout << "    --power-budget W --energy-budget J  governor: shed threads/duty to stay under W, stop after J" << std::endl;
+        std::cout << "    --transactions FILE         queue JSONL transactions ({kind, from, to, amount, fee}) before mining" << std::endl;
+        std::cout << "  pool [blocks]             - Serve mining work to workers (chain options as mine)" << std::endl;
+        std::cout << "    --listen tcp:HOST:PORT|unix:PATH  (default: tcp:127.0.0.1:3333)" << std::endl;
+        std::cout << "    --range-bits B              nonces per work unit, 2^B (default: 24)" << std::endl;
+        std::cout << "    --share-factor F            share target F times easier than blocks (default: 256)" << std::endl;
+        std::cout << "    --secret S                  shared secret every client must present (or SATOSHI_MIRROR_POOL_SECRET);" << std::endl;
+        std::cout << "                                worker, grant, transfer and import --connect take the same" << std::endl;
+        std::cout << "  worker                     - Mine for a pool (--connect ENDPOINT, --threads, --hash-kernel)" << std::endl;
+        std::cout << "  grant <agent> <amount>     - Queue a grant in a running pool's mempool (--connect)" << std::endl;
+        std::cout << "  transfer <from> <to> <amount> - Queue a transfer between agents (--fee F, --connect)" << std::endl;
+        std::cout << "  import <chain.jsonl>        - Add another node's blocks; the heaviest chain wins (--store, --connect)" << std::endl;
+        std::cout << "  snapshot [--store S] [--prune] - Snapshot balances at the tip; --prune empties old binary segments" << std::endl;
+        std::cout << "  restore [--store S]        - Rebuild ledger balances from the newest snapshot plus later blocks" << std::endl;
+        std::cout << "    (after --prune, restore needs a snapshot above the pruned range; older blocks are gone)" << std::endl;
+        std::cout << "  verify [--store S] [--threads N] [--chain-hash H] - Re-check every block of the chain in parallel" << std::endl;
+        std::cout << "  export-jsonl [file]       - Export the binary block store as JSONL (default: mirror_chain.export.jsonl)" << std::endl;
+        std::cout << "  stats [--json]             - Hashrate and phase timings of the running/last miner" << std::endl;
         std::cout << "  ai_cycle                   - Run quantum AI cycle" << std::endl;
         std::cout << "  energy [interval]         - Monitor quantum energy" << std::endl;
-        std::cout << "  quantum_synthesis          - Full parallel execution" << std::endl;
+        std::cout << "  quantum_synthesis          - Full parallel execution (--power-budget, --energy-budget)" << std::endl;
+        std::cout << "Any command: --deterministic [--seed N]  virtual clock and seeded RNG, reproducible runs" << std::endl;
+        std::cout << "             --placement cores|off      pin hashing threads one per physical core, I/O apart" << std::endl;
         std::cout << std::endl;
         std::cout << "Example: ./satoshi_mirror add_agent bot_rami \"Rami Quantum\"" << std::endl;
     }
 };
 
+#ifdef SATOSHI_MIRROR_BENCH
+// ==================== MINING BENCHMARKS ====================
+// Built by `make bench` from this same file. Every case runs single-threaded
+// for a fixed wall-clock budget and reports ns/op, hashes/s and TSC cycles per
+// hash, so runs on one machine are comparable build to build.
+namespace Bench {
+
+constexpr auto budget = std::chrono::milliseconds(300);
+
+// Keeps the optimizer from discarding a benchmarked result
+template <typename T>
+inline qfunc keep(const T& value) -> void {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// `warmup` ops first warm caches and branch predictors; the clock is read
+// every `chunk` ops. Disk-bound cases pass 0 and 1, so a case that syncs does
+// not spend seconds warming up or overrun its budget by a thousand syncs.
+template <typename Op>
+static qfunc measure(QubistString name, uint64_t hashes_per_op, Op op, int warmup = 1000, int chunk = 1024) -> QubistDict {
+    for(int i = 0; i < warmup; i++) op(uint32_t(i));
+
+    uint64_t ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t tsc_start = __rdtsc();
+    auto deadline = start + budget;
+    while(std::chrono::steady_clock::now() < deadline) {
+        for(int i = 0; i < chunk; i++, ops++) op(uint32_t(ops));
+    }
+    uint64_t tsc = __rdtsc() - tsc_start;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    QubistDict result = {
+        {"name", name},
+        {"ops", QubistInt(ops)},
+        {"ns_per_op", ns / ops}
+    };
+    if(hashes_per_op) {
+        result["hashes_per_s"] = QubistFloat(ops * hashes_per_op) * 1e9 / ns;
+        result["cycles_per_hash"] = QubistFloat(tsc) / QubistFloat(ops * hashes_per_op);
+    }
+    std::cerr << "  " << name << ": " << ns / ops << " ns/op" << std::endl;
+    return result;
+}
+
+// Correctness assertions run alongside the timings; any failure fails the run
+static QubistList checks;
+static QubistBool failed = false;
+
+static qfunc check(QubistString name, QubistBool passed) -> void {
+    checks.push_back(QubistDict{{"name", name}, {"passed", passed}});
+    if(!passed) failed = true;
+    std::cerr << "  " << (passed ? "✅ " : "❌ ") << name << std::endl;
+}
+
+static qfunc sample_header(uint32_t bits) -> QuantumBlockHeader {
+    QuantumBlockHeader header;
+    for(int i = 0; i < 32; i++) {
+        header.previous_hash[i] = uint8_t(i * 7 + 1);
+        header.merkle_root[i] = uint8_t(i * 13 + 5);
+    }
+    header.time = 1700000000;
+    header.bits = bits;
+    return header;
+}
+
+// ==================== CORRECTNESS CHECKS ====================
+// Known answers and round trips, run before any timing by `make bench` and
+// on their own by `make check`
+
+// mantissa * 256^(exponent - 3) written out big-endian, independently of QuantumTarget
+static qfunc expand_compact(uint32_t bits, uint8_t* value) -> void {
+    std::memset(value, 0, 32);
+    int size = int(bits >> 24);
+    for(int i = 0; i < 3; i++) {
+        int idx = 32 - size + i;
+        if(idx >= 0 && idx < 32) value[idx] = uint8_t(bits >> (16 - 8 * i));
+    }
+}
+
+static qfunc check_targets() -> void {
+    // Bitcoin's genesis target needs 2^256 / (0xffff * 256^26) = 0x100010001 hashes
+    ChainWork genesis = QuantumTarget::from_compact(0x1d00ffff).work();
+    check("target/genesis_work", genesis.high == 0 && genesis.low == 0x100010001);
+
+    std::vector<uint32_t> samples = {0x1d00ffff, 0x1b0404cb, 0x207fffff, 0x1f00ffff, 0x03123456};
+    for(unsigned zero_bits = 8; zero_bits <= 240; zero_bits++) {
+        samples.push_back(QuantumTarget::from_zero_bits(zero_bits).bits());
+    }
+    QubistBool round_trip = true, scaled = true, boundary = true;
+    for(uint32_t bits : samples) {
+        QuantumTarget target = QuantumTarget::from_compact(bits);
+        round_trip = round_trip && target.bits() == bits;
+        scaled = scaled && target.scaled(1.0).bits() == bits;
+
+        // The target itself meets it; one more does not
+        uint8_t value[32];
+        expand_compact(bits, value);
+        boundary = boundary && target.met_by(value);
+        for(int i = 31; i >= 0 && ++value[i] == 0; i--) {}
+        boundary = boundary && !target.met_by(value);
+    }
+    check("target/compact_round_trip", round_trip);
+    check("target/scaled_identity", scaled);
+    check("target/met_by_boundary", boundary);
+
+    QubistBool hex_zeros = true;
+    for(QubistInt zeros = 1; zeros <= 60; zeros++) {
+        hex_zeros = hex_zeros && std::abs(QuantumTarget::from_hex_zeros(zeros).difficulty() - zeros) < 0.01;
+    }
+    check("target/hex_zeros_difficulty", hex_zeros);
+
+    QubistBool rejected = false;
+    try { QuantumTarget::from_compact(0x1d800000); } catch(const std::invalid_argument&) { rejected = true; }
+    check("target/negative_rejected", rejected);
+}
+
+static qfunc check_store() -> void {
+    const char* digits = "123456789";
+    check("store/crc32c_known_answer", BlockStore::crc32c(reinterpret_cast<const uint8_t*>(digits), 9) == 0xe3069283);
+
+    QubistString directory = (std::filesystem::temp_directory_path() / "satoshi_mirror_check_store").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    QubistString path = BlockStore::segment_path(directory, 0);
+
+    std::vector<QubistString> frames;
+    {
+        std::ofstream out(path, std::ios::binary);
+        for(uint64_t height = 0; height < 3; height++) {
+            StoredBlock block;
+            block.header = sample_header(QuantumTarget::from_hex_zeros(1).bits());
+            block.height = height;
+            block.hash = Hash256::of(&height, sizeof(height));
+            frames.push_back(BlockStore::frame(block, "extension"));
+            out << frames.back();
+        }
+    }
+    size_t two_frames = frames[0].size() + frames[1].size();
+
+    StoredBlock tip;
+    QubistInt visited = BlockStore::for_each(directory, [](const StoredBlock&, std::string_view) { return true; });
+    check("store/walk_all", visited == 3 && BlockStore::recover_tip(directory, tip) && tip.height == 2);
+
+    // A flipped payload byte fails the CRC: the record is unreadable and cut off
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(std::streamoff(two_frames + sizeof(BlockStore::FrameHeader) + 8));
+        file.put('\xff');
+    }
+    StoredBlock block;
+    std::string extension;
+    QubistBool unreadable = !BlockStore::read_at(directory, BlockStore::location(0, two_frames), block, extension);
+    QubistBool readable = BlockStore::read_at(directory, BlockStore::location(0, frames[0].size()), block, extension) &&
+                          block.height == 1 && extension == "extension";
+    check("store/crc_rejects_corrupt", unreadable && readable);
+    QubistBool recovered = BlockStore::recover_tip(directory, tip) && tip.height == 1;
+    check("store/corrupt_tail_dropped", recovered && std::filesystem::file_size(path) == two_frames);
+
+    // Half a record, as a crash mid-write leaves it
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << frames[2].substr(0, frames[2].size() / 2);
+    }
+    recovered = BlockStore::recover_tip(directory, tip) && tip.height == 1;
+    check("store/torn_tail_dropped", recovered && std::filesystem::file_size(path) == two_frames);
+
+    std::filesystem::remove_all(directory);
+}
+
+// Producers racing on a small segment limit: every record lands whole at
+// the location append() returned for it
+static qfunc check_chain_writer() -> void {
+    QubistString directory = (std::filesystem::temp_directory_path() / "satoshi_mirror_check_writer").string();
+    std::filesystem::remove_all(directory);
+    constexpr uint64_t threads = 4, per_thread = 500;
+    std::vector<std::pair<uint64_t, uint64_t>> placed(threads * per_thread);     // location, height
+    {
+        ChainWriter writer(directory, 64 << 10, DurabilityPolicy{Durability::none});
+        std::vector<std::thread> producers;
+        for(uint64_t t = 0; t < threads; t++) {
+            producers.emplace_back([&, t]() {
+                for(uint64_t i = 0; i < per_thread; i++) {
+                    StoredBlock block;
+                    block.height = t * per_thread + i;
+                    std::string padding(size_t(block.height % 300), 'x');
+                    placed[block.height] = {writer.append(BlockStore::frame(block, padding)), block.height};
+                }
+            });
+        }
+        for(auto& producer : producers) producer.join();
+        writer.drain();
+    }
+
+    QubistBool in_place = true;
+    for(const auto& [at, height] : placed) {
+        StoredBlock block;
+        std::string extension;
+        in_place = in_place && BlockStore::read_at(directory, at, block, extension) && block.height == height;
+    }
+    QubistInt stored = BlockStore::for_each(directory, [](const StoredBlock&, std::string_view) { return true; });
+    check("writer/concurrent_locations", in_place && stored == QubistInt(placed.size()) &&
+                                         BlockStore::segment_count(directory) > 1);
+    std::filesystem::remove_all(directory);
+}
+
+static qfunc check_mempool() -> void {
+    auto transfer = [](QubistFloat amount, QubistFloat fee, uint64_t timestamp) {
+        QuantumTransaction tx;
+        tx.kind = QuantumTransaction::transfer;
+        tx.from = "alice";
+        tx.to = "bob";
+        tx.amount = amount;
+        tx.fee = fee;
+        tx.timestamp = timestamp;
+        tx.seal();
+        return tx;
+    };
+    auto accepted = [](Mempool& pool, const QuantumTransaction& tx, QubistFloat balance) {
+        try { pool.submit(tx, balance); return true; } catch(const std::invalid_argument&) { return false; }
+    };
+
+    // alice holds 10: a spend of 7 reserves it, so a further 4 is refused
+    Mempool pool;
+    QuantumTransaction cheap = transfer(6.0, 1.0, 1), rich = transfer(2.0, 2.0, 2);
+    QubistBool reserved = accepted(pool, cheap, 10.0) && !accepted(pool, rich, 10.0);
+    reserved = reserved && !accepted(pool, cheap, 10.0) && pool.size() == 1;
+    check("mempool/reservation", reserved);
+
+    // Taken into a template the spend stays reserved, and comes back on restore
+    std::vector<QuantumTransaction> block = pool.take_block(1000);
+    QubistBool held = block.size() == 1 && pool.size() == 0 && !accepted(pool, rich, 10.0);
+    pool.restore(block);
+    held = held && pool.size() == 1 && !accepted(pool, rich, 10.0);
+    check("mempool/take_restore", held);
+
+    // Connected, the reservation goes with it: alice's remaining 3 is spendable
+    block = pool.take_block(1000);
+    pool.remove(block);
+    check("mempool/remove_releases", pool.size() == 0 && accepted(pool, transfer(2.0, 1.0, 3), 3.0));
+
+    // Confirmed while pending, then disconnected by a reorg: the same
+    // transaction is taken back once, not refused as a duplicate
+    Mempool revive;
+    QubistBool revived = accepted(revive, cheap, 20.0) && accepted(revive, rich, 20.0);
+    revive.remove({cheap});
+    revived = revived && revive.size() == 1 && accepted(revive, cheap, 20.0) && revive.size() == 2;
+    block = revive.take_block(1000);
+    revived = revived && block.size() == 2 && revive.size() == 0;
+    check("mempool/revive_after_reorg", revived);
+
+    // Highest fee rate first
+    check("mempool/fee_priority", block.size() == 2 && block[0].id == rich.id && block[1].id == cheap.id);
+}
+
+// A ledger file in the temp directory, with its journal and checkpoint leftovers
+static qfunc scratch_ledger(const QubistString& name) -> QubistString {
+    QubistString path = (std::filesystem::temp_directory_path() / name).string();
+    for(const char* leftover : {"", ".wal", ".wal.old", ".tmp"}) std::filesystem::remove(path + leftover);
+    return path;
+}
+
+static qfunc check_reorg_undo() -> void {
+    QubistString path = scratch_ledger("satoshi_mirror_check_reorg.json");
+    auto transaction = [](QuantumTransaction::Kind kind, QubistString from, QubistString to, QubistFloat amount,
+                          QubistFloat fee) {
+        QuantumTransaction tx;
+        tx.kind = kind;
+        tx.from = from;
+        tx.to = to;
+        tx.amount = amount;
+        tx.fee = fee;
+        tx.seal();
+        return tx;
+    };
+    Hash256 first = Hash256::of("first", 5), second = Hash256::of("second", 6);
+    using Balances = std::vector<std::pair<QubistString, QubistFloat>>;
+    Balances before, after_first;
+    {
+        QuantumLedger ledger(path);
+        ledger.open_journal();
+        for(const char* id : {"alice", "bob", "payee"}) ledger.add_agent(id, id);
+        ledger.grant_btc("alice", 10.0);
+        before = ledger.balances();
+
+        ledger.connect_block(first, {transaction(QuantumTransaction::transfer, "alice", "bob", 3.0, 1.0)}, "payee", 51.0);
+        after_first = ledger.balances();
+        ledger.connect_block(second, {transaction(QuantumTransaction::grant, "", "bob", 5.0, 0.0)}, "payee", 50.0);
+    }
+
+    // Undo records survive the checkpoint; only the newest block comes off
+    {
+        QuantumLedger ledger(path);
+        ledger.open_journal();
+        QubistBool booked = ledger.balance_of("alice") == 6.0 && ledger.balance_of("bob") == 8.0 &&
+                            ledger.balance_of("payee") == 101.0;
+        ledger.disconnect_block(first);
+        check("reorg/connect_books_deltas", booked && ledger.balance_of("bob") == 8.0);
+        ledger.disconnect_block(second);
+        QubistBool one_off = ledger.balances() == after_first;
+        ledger.disconnect_block(first);
+        check("reorg/disconnect_restores", one_off && ledger.balances() == before);
+    }
+    check("reorg/undo_persisted", QuantumLedger(path).balances() == before);
+
+    for(const char* leftover : {"", ".wal", ".wal.old", ".tmp"}) std::filesystem::remove(path + leftover);
+}
+
+static qfunc check_journal() -> void {
+    QubistString path = scratch_ledger("satoshi_mirror_check_journal.json");
+    QubistFloat base = 0.0;
+    {
+        QuantumLedger ledger(path);
+        ledger.open_journal();
+        ledger.add_agent("alice", "alice");
+        ledger.grant_btc("alice", 1.0);
+        base = *ledger.balance_of("alice");
+    }
+    std::ifstream checkpoint(path);
+    uint64_t checkpoint_seq = QubistInt(QubistDict(json::parse(checkpoint))["checkpoint_seq"]);
+
+    // What a crash leaves: a retired log whose checkpoint never landed, a
+    // live log repeating its last record, and a line torn mid-append
+    auto credit = [](uint64_t seq, QubistFloat amount) {
+        return json::dump(QubistDict{{"op", "credit"}, {"id", "alice"}, {"amount", amount}, {"seq", seq}}) + "\n";
+    };
+    std::ofstream(path + ".wal.old") << credit(checkpoint_seq + 1, 2.0);
+    std::ofstream(path + ".wal") << credit(checkpoint_seq + 1, 2.0) << credit(checkpoint_seq + 2, 4.0)
+                                 << credit(checkpoint_seq + 3, 8.0).substr(0, 20);
+
+    QubistBool replayed = QuantumLedger(path).balance_of("alice") == base + 6.0;
+    check("journal/replay_skips_repeats_and_torn_tail", replayed && std::filesystem::exists(path + ".wal"));
+
+    // Taking the ledger for writing folds the logs into a new checkpoint, so
+    // nothing appended later sits behind the torn line
+    {
+        QuantumLedger ledger(path);
+        ledger.open_journal();
+        replayed = !std::filesystem::exists(path + ".wal.old") && std::filesystem::file_size(path + ".wal") == 0;
+        ledger.grant_btc("alice", 16.0);
+    }
+    check("journal/compacts_on_open", replayed && QuantumLedger(path).balance_of("alice") == base + 22.0);
+
+    for(const char* leftover : {"", ".wal", ".wal.old", ".tmp"}) std::filesystem::remove(path + leftover);
+}
+
+static qfunc run_checks() -> void {
+    for(const HashKernels::Kernel& kernel : HashKernels::supported()) {
+        check(QubistString("kernel/") + kernel.name + "/known_answer", HashKernels::agrees(kernel));
+    }
+    check_targets();
+    check_store();
+    check_chain_writer();
+    check_mempool();
+    check_reorg_undo();
+    check_journal();
+}
+
+static qfunc run_all() -> QubistDict {
+    run_checks();
+
+    QubistList results;
+    QuantumBlockHeader header = sample_header(QuantumTarget::from_hex_zeros(4).bits());
+    QuantumMidstate midstate(header);
+
+    // Whole-buffer OpenSSL path vs the precomputed midstate
+    results.push_back(measure("hash/full", 1, [&](uint32_t nonce) {
+        QuantumBlockHeader attempt = header;
+        attempt.nonce = nonce;
+        unsigned char digest[32];
+        SHA256(attempt.bytes(), sizeof(QuantumBlockHeader), digest);
+        keep(digest[0]);
+    }));
+    results.push_back(measure("hash/midstate", 1, [&](uint32_t nonce) {
+        unsigned char digest[32];
+        midstate.hash(nonce, digest);
+        keep(digest[0]);
+    }));
+
+    for(const HashKernels::Kernel& kernel : HashKernels::available()) {
+        results.push_back(measure(QubistString("kernel/") + kernel.name, kernel.lanes, [&](uint32_t nonce) {
+            alignas(64) unsigned char digests[16 * 32];
+            HashKernels::hash_batch(kernel, midstate, nonce * kernel.lanes, digests);
+            keep(digests[0]);
+        }));
+    }
+
+    // Digest hex codec, both directions
+    Hash256 sample_digest = Hash256::of(header.bytes(), sizeof(QuantumBlockHeader));
+    QubistString sample_hex = sample_digest.to_hex();
+    results.push_back(measure("hex/encode", 0, [&](uint32_t nonce) {
+        char hex[Hash256::hex_size];
+        sample_digest[0] = uint8_t(nonce);
+        sample_digest.write_hex(hex);
+        keep(hex[1]);
+    }));
+    results.push_back(measure("hex/decode", 0, [&](uint32_t nonce) {
+        sample_hex[63] = "0123456789abcdef"[nonce & 15];
+        keep(Hash256::from_hex(sample_hex)[31]);
+    }));
+
+    // Chain hash policies, one header each
+    auto hash_case = [&]<typename Hash>() {
+        results.push_back(measure(QubistString("policy/") + Hash::name, 1, [&](uint32_t nonce) {
+            QuantumBlockHeader attempt = header;
+            attempt.nonce = nonce;
+            unsigned char digest[32];
+            Hash::hash(attempt, digest);
+            keep(digest[0]);
+        }));
+    };
+    hash_case.template operator()<HashPolicy::Sha256Single>();
+    hash_case.template operator()<HashPolicy::Sha256Double>();
+    hash_case.template operator()<HashPolicy::Fast>();
+
+    // Target checks and block serialization across difficulties
+    std::vector<std::array<unsigned char, 32>> digests(4096);
+    for(size_t i = 0; i < digests.size(); i++) midstate.hash(uint32_t(i), digests[i].data());
+
+    for(QubistInt zeros : {1, 4, 6, 8}) {
+        QuantumTarget target = QuantumTarget::from_hex_zeros(zeros);
+        QubistString suffix = "/d" + std::to_string(zeros);
+
+        results.push_back(measure("target/met_by" + suffix, 0, [&](uint32_t i) {
+            keep(target.met_by(digests[i & 4095].data()));
+        }));
+        results.push_back(measure("target/headword" + suffix, 0, [&](uint32_t i) {
+            keep(TargetCheck::HeadWord::first_hit(target, digests[(i * 8) & 4095].data(), 8));
+        }));
+
+        StoredBlock stored;
+        stored.header = sample_header(target.bits());
+        stored.height = 1000;
+        midstate.hash(0, stored.hash.data());
+        stored.mining_time = 1.5;
+        stored.reward = 50.0;
+
+        results.push_back(measure("serialize/json" + suffix, 0, [&](uint32_t nonce) {
+            stored.header.nonce = nonce;
+            std::string record = json::dump(QuantumMiner::render_block(stored));
+            keep(record.size());
+        }));
+        results.push_back(measure("serialize/binary" + suffix, 0, [&](uint32_t nonce) {
+            stored.header.nonce = nonce;
+            std::string record = BlockStore::frame(stored);
+            keep(record.size());
+        }));
+    }
+
+    // Agent lookups and grant booking as the ledger grows: flat ns/op across
+    // sizes means the id index is doing its job
+    QubistString ledger_path = (std::filesystem::temp_directory_path() / "satoshi_mirror_bench_ledger.json").string();
+    for(QubistInt agents : {1000, 10000, 100000}) {
+        std::filesystem::remove(ledger_path);
+        QuantumLedger ledger(ledger_path);
+        ledger.open_journal();
+        std::vector<std::pair<QubistString, QubistFloat>> population;
+        for(QubistInt i = 0; i < agents; i++) population.emplace_back("bench_agent_" + std::to_string(i), 0.0);
+        ledger.restore_balances(population);
+        QubistString suffix = "/n" + std::to_string(agents);
+
+        results.push_back(measure("ledger/balance_of" + suffix, 0, [&](uint32_t i) {
+            keep(ledger.balance_of(population[(i * 2654435761u) % agents].first).has_value());
+        }));
+        std::vector<QuantumTransaction> grant(1);
+        grant[0].kind = QuantumTransaction::grant;
+        grant[0].amount = 1.0;
+        results.push_back(measure("ledger/grant" + suffix, 0, [&](uint32_t i) {
+            grant[0].to = population[(i * 2654435761u) % agents].first;
+            ledger.connect_block(Hash256{}, grant, "", 0.0, false);
+        }));
+        // Journaled grants, each returning only once its record is synced;
+        // background checkpoints included
+        results.push_back(measure("ledger/grant_logged" + suffix, 0, [&](uint32_t i) {
+            ledger.grant_btc(population[(i * 2654435761u) % agents].first, 1.0);
+        }, 0, 1));
+        // The same grants booked 1024 to a sync, as a block or grant_many() books them
+        std::vector<std::pair<QubistString, QubistFloat>> batch(1024);
+        results.push_back(measure("ledger/grant_many_1024" + suffix, 0, [&](uint32_t i) {
+            for(uint32_t j = 0; j < batch.size(); j++) {
+                batch[j] = {population[((i * 1024 + j) * 2654435761u) % agents].first, 1.0};
+            }
+            ledger.grant_many(batch);
+        }, 0, 1));
+    }
+    for(const char* leftover : {"", ".wal", ".wal.old", ".tmp"}) std::filesystem::remove(ledger_path + leftover);
+
+    return QubistDict{
+        {"auto_kernel", QubistString(HashKernels::best().name)},
+        {"hardware_threads", QubistInt(NonceSearch::hardware_threads())},
+        {"results", results},
+        {"checks", checks}
+    };
+}
+
+} // namespace Bench
+#endif
+
 } // namespace SatoshiMirror
 
 // ==================== QUBIST MAIN ENTRY POINT ====================
+#ifndef SATOSHI_MIRROR_BENCH
 qfunc main(QubistInt argc, QubistString argv[]) -> QubistInt {
-    std::cout << "🚀 Initializing Satoshi Mirror core (Qubist-C++)..." << std::endl;
+    // On stderr, so stdout carries only the command's output (`stats --json`)
+    std::cerr << "🚀 Initializing Satoshi Mirror core (Qubist-C++)..." << std::endl;
+   
+    // Clock, RNG and thread placement are chosen before anything uses them.
+    // Global flags may come before or after the mode; the first other
+    // argument is the mode.
+    SatoshiMirror::QubistList args;
+    SatoshiMirror::QubistBool deterministic = false;
+    uint64_t seed = 0;
+    for(QubistInt i = 1; i < argc; i++) {
+        QubistString arg = argv[i];
+        if(arg == "--deterministic") deterministic = true;
+        else if(arg == "--seed" && i + 1 < argc) seed = std::strtoull(QubistString(argv[++i]).c_str(), nullptr, 0);
+        else if(arg == "--placement" && i + 1 < argc) SatoshiMirror::Placement::active = QubistString(argv[++i]) != "off";
+        else args.push_back(argv[i]);
+    }
+    if(deterministic) SatoshiMirror::Simulation::enable(seed);
    
     SatoshiMirror::SatoshiMirrorCore core;
    
-    if(argc < 2) {
+    if(args.empty()) {
         core.show_help();
         return 1;
     }
    
-    QubistString mode = argv[1];
-    SatoshiMirror::QubistList args;
-   
-    for(QubistInt i = 2; i < argc; i++) {
-        args.push_back(argv[i]);
-    }
+    QubistString mode = args[0];
+    args.erase(args.begin());
    
     try {
         core.execute(mode, args);
@@ -501,3 +6409,23 @@ qfunc main(QubistInt argc, QubistString argv[]) -> QubistInt {
    
     return 0;
 }
+#else
+// JSON report on stdout, progress on stderr: `make bench > bench.json`;
+// `satoshi_mirror_bench check` runs only the correctness checks
+qfunc main(QubistInt argc, QubistString argv[]) -> QubistInt {
+    // Whatever the exercised code prints goes to stderr with the progress
+    std::streambuf* report = std::cout.rdbuf(std::cerr.rdbuf());
+    SatoshiMirror::QubistDict result;
+    if(argc > 1 && QubistString(argv[1]) == "check") {
+        std::cerr << "🔎 Running correctness checks..." << std::endl;
+        SatoshiMirror::Bench::run_checks();
+        result = SatoshiMirror::QubistDict{{"checks", SatoshiMirror::Bench::checks}};
+    } else {
+        std::cerr << "⏱️  Benchmarking mining kernels..." << std::endl;
+        result = SatoshiMirror::Bench::run_all();
+    }
+    std::cout.rdbuf(report);
+    std::cout << json::dump(result) << std::endl;
+    return SatoshiMirror::Bench::failed ? 1 : 0;
+}
+#endif